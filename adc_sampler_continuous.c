@@ -7,6 +7,8 @@
 #include <time.h>
 #include <signal.h>
 
+#include "pru/pru_ring.h"
+
 #define ADC_TSC_BASE 0x44E0D000
 #define MAP_SIZE 4096
 
@@ -24,7 +26,7 @@
 // Shared memory for output
 #define PRU_SHARED_MEM 0x4A310000
 #define PRU_MEM_SIZE 0x3000
-#define BUFFER_SIZE 1024
+#define BUFFER_SIZE PRU_RING_SLOT_SAMPLES
 
 volatile int keep_running = 1;
 
@@ -36,11 +38,10 @@ int main() {
     int mem_fd;
     void *adc_map, *shared_map;
     volatile uint32_t *adc_mem;
-    volatile uint16_t *buffer_a, *buffer_b;
-    volatile uint8_t *ready_flag;
+    volatile struct pru_ring_header *ring;
 
     struct timespec buffer_start, buffer_end;
-    uint16_t current_buffer = 1;  // 1=A, 2=B
+    uint32_t write_seq = 0;
 
     printf("ARM ADC Sampler (48 kHz) - CONTINUOUS MODE\n");
     printf("============================================\n\n");
@@ -74,9 +75,7 @@ int main() {
         return 1;
     }
 
-    buffer_a = (volatile uint16_t *)shared_map;
-    buffer_b = buffer_a + BUFFER_SIZE;
-    ready_flag = (volatile uint8_t *)((char*)shared_map + 0x1000);
+    ring = (volatile struct pru_ring_header *)((char*)shared_map + PRU_RING_HEADER_OFFSET);
 
     printf("Mapped memory successfully\n");
 
@@ -110,14 +109,23 @@ int main() {
     // OpenDelay = small (say 1), SampleDelay controls rate
     adc_mem[STEPDELAY1/4] = (1 << 0) | (14 << 24);  // Adjust sample delay
 
-    *ready_flag = 0;  // Clear flag
+    // Initialize ring header (we stand in for the PRU producer)
+    ring->magic = 0;
+    ring->version = PRU_RING_VERSION;
+    ring->num_slots = PRU_RING_NUM_SLOTS;
+    ring->slot_samples = PRU_RING_SLOT_SAMPLES;
+    ring->write_seq = 0;
+    ring->read_seq = 0;
+    ring->overrun_count = 0;
+    __sync_synchronize();
+    ring->magic = PRU_RING_MAGIC;
 
     printf("Sampling with polling (low CPU overhead)...\n");
     printf("Press Ctrl+C to stop\n\n");
 
     int sample_count = 0;
     int buffer_count = 0;
-    volatile uint16_t *current_buf = buffer_a;
+    volatile uint16_t *current_buf = pru_ring_slot(shared_map, write_seq);
 
     uint16_t min_sample = 4095, max_sample = 0;
     int empty_polls = 0;
@@ -161,25 +169,24 @@ int main() {
                                   (buffer_end.tv_nsec - buffer_start.tv_nsec) / 1000L;
             double actual_rate = 1000000.0 * BUFFER_SIZE / buffer_time_us;
 
-            printf("Buffer %d: %.1f Hz | Min: %d (%.3fV) Max: %d (%.3fV)\n",
+            // Publish slot (don't wait for the reader)
+            __sync_synchronize();
+            ring->write_seq = ++write_seq;
+            if (write_seq - ring->read_seq >= PRU_RING_NUM_SLOTS) {
+                ring->overrun_count++;
+            }
+
+            printf("Buffer %d: %.1f Hz | Min: %d (%.3fV) Max: %d (%.3fV) | Lag: %u Overruns: %u\n",
                    buffer_count, actual_rate,
                    min_sample, min_sample * 1.8 / 4095.0,
-                   max_sample, max_sample * 1.8 / 4095.0);
-
-            // Set ready flag (don't wait for clear)
-            *ready_flag = current_buffer;
+                   max_sample, max_sample * 1.8 / 4095.0,
+                   write_seq - ring->read_seq, ring->overrun_count);
 
             buffer_count++;
             clock_gettime(CLOCK_MONOTONIC, &buffer_start);
 
-            // Switch buffers
-            if (current_buffer == 1) {
-                current_buffer = 2;
-                current_buf = buffer_b;
-            } else {
-                current_buffer = 1;
-                current_buf = buffer_a;
-            }
+            // Move to next slot
+            current_buf = pru_ring_slot(shared_map, write_seq);
 
             sample_count = 0;
             min_sample = 4095;
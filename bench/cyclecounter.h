@@ -0,0 +1,65 @@
+#ifndef CYCLECOUNTER_H
+#define CYCLECOUNTER_H
+
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// CPU cycles via perf_event_open (works on x86 and the Cortex-A8 PMU).
+// If the kernel refuses (perf_event_paranoid, no PMU driver) cycles()
+// returns 0 and only wall time is reported.
+class CycleCounter {
+public:
+    CycleCounter() {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~CycleCounter() {
+        if (m_fd >= 0) close(m_fd);
+    }
+
+    bool isAvailable() const { return m_fd >= 0; }
+
+    void start() {
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &m_start);
+    }
+
+    void stop() {
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        m_ns = (end.tv_sec - m_start.tv_sec) * 1000000000LL + (end.tv_nsec - m_start.tv_nsec);
+        m_cycles = 0;
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long count = 0;
+            if (read(m_fd, &count, sizeof(count)) == sizeof(count))
+                m_cycles = count;
+        }
+    }
+
+    int64_t nanoseconds() const { return m_ns; }
+    int64_t cycles() const { return m_cycles; }
+
+private:
+    int m_fd;
+    struct timespec m_start;
+    int64_t m_ns;
+    int64_t m_cycles;
+};
+
+#endif
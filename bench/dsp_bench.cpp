@@ -0,0 +1,1084 @@
+// DSP kernel benchmark: per-frame sample conversion as DSPThread did it
+// before (append + divide per sample, separate DC and stats passes, cos()
+// per sample in the window, copy into the FFT input) versus the fused
+// convertWindowFrame() kernel.
+//
+// The accuracy mode runs the same ADC frames through the float64 and
+// float32 pipelines (kernels + FFTW/FFTWF) and shows how far the float32
+// rounding error sits below the 12-bit ADC's own quantization noise.
+//
+// The db mode checks the fast power-to-dB kernel's error bound over every
+// float mantissa and times it against the old sqrt + log10 + append loop.
+//
+// The alloc mode drives the spectrum publish path (frame pool, bus,
+// reader thread) and counts heap allocations once it is warm.
+//
+// The bus mode publishes to a UI-like, a stalled and a slow subscriber at
+// once and checks the publisher's timing doesn't depend on them.
+//
+// The decimate mode maps every FFT size onto an LCD-wide log frequency
+// axis and checks the pixel-column decimation keeps each column's min/max
+// while drawing at most 4 points per column.
+//
+// The persistence mode feeds every FFT size into an LCD-sized persistence
+// grid, times add + amortized decay per spectrum, and checks a steady
+// tone saturates its cells and fades by half over the half-life.
+//
+// The suite mode times every kernel on the spectrum path - convert +
+// window, FFT execute, power, dB, pixel-column decimation and persistence -
+// at each FFT size from 256 to 65536 in float64 and float32, as ns/frame,
+// ns/sample, frames/s and cycles/frame. --json prints the same as one JSON
+// document, to compare dev boxes against BeagleBone runs.
+//
+// The profile mode times Profiler::record with profiling off and on, then
+// records from several threads while a reader collects and checks every
+// sample is counted exactly once. Recording must not allocate.
+//
+// Usage: dsp_bench [fft_size] [iterations]
+//        dsp_bench accuracy [fft_size]     (default: sweep 256..65536)
+//        dsp_bench db [iterations]
+//        dsp_bench alloc [fft_size] [spectra]
+//        dsp_bench bus [spectra]
+//        dsp_bench decimate [width_px]
+//        dsp_bench persistence [width_px] [height_px]
+//        dsp_bench profile [samples_per_thread]
+//        dsp_bench suite [fft_size] [--json] [--estimate]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <new>
+#include <sys/utsname.h>
+#include <fftw3.h>
+#include "cyclecounter.h"
+#include "dspkernels.h"
+#include "spectrumdata.h"
+#include "spectrumbus.h"
+#include "columndecimator.h"
+#include "persistencegrid.h"
+#include "profiler.h"
+
+// Every operator new in the process goes through here, for the alloc mode
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+// Keeps the optimizer from discarding results
+static volatile double g_sink;
+
+static void fillTestSignal(uint16_t *raw, int n) {
+    // 1 kHz at 48 kHz around mid-scale, plus a little deterministic noise
+    unsigned seed = 1;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double v = 2048.0 + 680.0 * sin(2.0 * M_PI * 1000.0 * i / 48000.0) + ((seed >> 16) % 9) - 4.0;
+        raw[i] = (uint16_t)v;
+    }
+}
+
+// The pre-fusion path, kept here only as the baseline
+static void legacyFrame(const uint16_t *read_buffer, double *fftInput, int numSamples,
+                        bool printStats) {
+    std::vector<double> samples;
+
+    double sum = 0.0;
+    for (int i = 0; i < numSamples; i++) {
+        uint16_t raw = read_buffer[i];
+        double voltage = (raw / 4095.0) * 1.8;
+        samples.push_back(voltage);
+        sum += voltage;
+    }
+
+    double dc_offset = sum / numSamples;
+    for (int i = 0; i < numSamples; i++) {
+        samples[i] -= dc_offset;
+    }
+
+    if (printStats) {
+        uint16_t min_raw = 4095, max_raw = 0;
+        sum = 0.0;
+        for (int i = 0; i < numSamples; i++) {
+            uint16_t raw = read_buffer[i];
+            if (raw < min_raw) min_raw = raw;
+            if (raw > max_raw) max_raw = raw;
+            sum += raw;
+        }
+        g_sink = min_raw + max_raw + sum;
+    }
+
+    int n = samples.size();
+    for (int i = 0; i < n; i++) {
+        double window = 0.5 * (1.0 - cos(2.0 * M_PI * i / (n - 1)));
+        samples[i] *= window;
+    }
+
+    for (int i = 0; i < numSamples; i++) {
+        fftInput[i] = samples[i];
+    }
+}
+
+struct Result {
+    double nsPerFrame;
+    double cyclesPerFrame;
+};
+
+template <typename F>
+static Result timeFrames(int iterations, F frame) {
+    CycleCounter counter;
+    frame(0);  // warm caches, page in buffers
+    counter.start();
+    for (int it = 0; it < iterations; it++) {
+        frame(it);
+    }
+    counter.stop();
+
+    Result r;
+    r.nsPerFrame = (double)counter.nanoseconds() / iterations;
+    r.cyclesPerFrame = counter.isAvailable() ? (double)counter.cycles() / iterations : 0.0;
+    return r;
+}
+
+static void report(const char *name, const Result &r, int n) {
+    printf("%-28s %10.1f ns/frame %8.2f ns/sample", name, r.nsPerFrame, r.nsPerFrame / n);
+    if (r.cyclesPerFrame > 0.0)
+        printf(" %12.0f cycles/frame", r.cyclesPerFrame);
+    else
+        printf("   (cycle counter unavailable)");
+    printf("\n");
+}
+
+// ---------------------------------------------------------------------------
+// float32 vs float64 accuracy
+// ---------------------------------------------------------------------------
+
+// Bin power -> dBFS the way DSPThread scales it (Hann, 0.9V full scale)
+static double binDbfs(double power, int n) {
+    double amplitude = 2.0 * sqrt(power) / (n * 0.5);
+    return 20.0 * log10(amplitude / 0.9 + 1e-300);
+}
+
+static bool accuracyCheck(int n) {
+    // Near full-scale tone between bins, quantized by a 12-bit ADC with a
+    // little dither so the quantization noise is white
+    std::vector<uint16_t> raw(n);
+    unsigned seed = 7;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double dither = ((seed >> 8) & 0xFFFF) / 65536.0 - 0.5;
+        double volts = 0.9 + 0.85 * sin(2.0 * M_PI * 1234.5 * i / 48000.0);
+        double code = floor(volts / ADC_VOLTS_PER_CODE + 0.5 + dither);
+        raw[i] = (uint16_t)std::max(0.0, std::min(4095.0, code));
+    }
+
+    double *windowD = (double*)fftw_malloc(sizeof(double) * n);
+    double *inD = (double*)fftw_malloc(sizeof(double) * n);
+    double *outD = (double*)fftw_malloc(sizeof(double) * n);
+    double *powerD = (double*)fftw_malloc(sizeof(double) * (n / 2 + 1));
+    float *windowF = (float*)fftwf_malloc(sizeof(float) * n);
+    float *inF = (float*)fftwf_malloc(sizeof(float) * n);
+    float *outF = (float*)fftwf_malloc(sizeof(float) * n);
+    float *powerF = (float*)fftwf_malloc(sizeof(float) * (n / 2 + 1));
+
+    fftw_plan planD = fftw_plan_r2r_1d(n, inD, outD, FFTW_R2HC, FFTW_ESTIMATE);
+    fftwf_plan planF = fftwf_plan_r2r_1d(n, inF, outF, FFTW_R2HC, FFTW_ESTIMATE);
+
+    makeHannWindow(windowD, n, ADC_VOLTS_PER_CODE);
+    makeHannWindow(windowF, n, ADC_VOLTS_PER_CODE);
+
+    convertWindowFrame(raw.data(), windowD, inD, n, nullptr);
+    convertWindowFrame(raw.data(), windowF, inF, n, nullptr);
+    fftw_execute(planD);
+    fftwf_execute(planF);
+    accumulatePower(outD, n, powerD, PowerReplace);
+    accumulatePower(outF, n, powerF, PowerReplace);
+
+    // Complex error of the float32 transform against float64, per bin
+    const int half = n / 2;
+    std::vector<double> noiseDb, errorPower;
+    double maxDbDiff = 0.0;
+    int peak = 1;
+    for (int k = 1; k < half; k++) {
+        if (powerD[k] > powerD[peak]) peak = k;
+    }
+    for (int k = 1; k < half; k++) {
+        double dr = (double)outF[k] - outD[k];
+        double di = (double)outF[n - k] - outD[n - k];
+        errorPower.push_back(dr * dr + di * di);
+
+        // ADC noise floor: bins clear of the tone's main lobe
+        if (abs(k - peak) > 4) {
+            noiseDb.push_back(binDbfs(powerD[k], n));
+        }
+        // What the display would show differently (above its -80 dB floor)
+        double dbD = binDbfs(powerD[k], n), dbF = binDbfs(powerF[k], n);
+        if (dbD > -80.0) {
+            maxDbDiff = std::max(maxDbDiff, fabs(dbF - dbD));
+        }
+    }
+
+    std::sort(noiseDb.begin(), noiseDb.end());
+    double adcFloor = noiseDb[noiseDb.size() / 2];
+    double meanError = 0.0;
+    for (double e : errorPower) meanError += e;
+    meanError /= errorPower.size();
+    double errorFloor = binDbfs(meanError, n);
+    double margin = adcFloor - errorFloor;
+
+    // float32 rounding must sit well under what the ADC can resolve
+    bool ok = margin >= 20.0 && maxDbDiff < 0.01;
+    printf("%6d %14.1f %16.1f %10.1f %16.5f   %s\n", n, adcFloor, errorFloor, margin,
+           maxDbDiff, ok ? "ok" : "FAIL");
+
+    fftw_destroy_plan(planD);
+    fftwf_destroy_plan(planF);
+    fftw_free(windowD); fftw_free(inD); fftw_free(outD); fftw_free(powerD);
+    fftwf_free(windowF); fftwf_free(inF); fftwf_free(outF); fftwf_free(powerF);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Power -> dB kernel
+// ---------------------------------------------------------------------------
+
+// The per-bin loop DSPThread::computeFFT used to run
+static void legacyDb(const double *halfComplex, int n, std::vector<double> &magnitudes) {
+    const double NORMALIZATION = n * 0.5;
+    magnitudes.clear();
+    for (int i = 1; i < n / 2; i++) {
+        double real = halfComplex[i];
+        double imag = halfComplex[n - i];
+        double mag = sqrt(real * real + imag * imag);
+        double voltage_amplitude = (mag / NORMALIZATION) * 2.0;
+        double db = 20.0 * log10(voltage_amplitude / 0.9 + 1e-10);
+        magnitudes.push_back(db > -80.0 ? db : -80.0);
+    }
+}
+
+static bool dbErrorBound() {
+    // The approximation error depends only on the mantissa, so one binade
+    // covers every mantissa exhaustively; the exponent sweep catches the
+    // float rounding of exponent + log2(mantissa) far from 1.0
+    double maxError = 0.0;
+    float worst = 1.0f;
+    const int CHUNK = 4096;
+    std::vector<float> in(CHUNK);
+    std::vector<double> out(CHUNK);
+
+    for (uint32_t m = 0; m < (1u << 23); m += CHUNK) {
+        for (int i = 0; i < CHUNK; i++) {
+            uint32_t bits = 0x3F800000u | (m + i);
+            memcpy(&in[i], &bits, sizeof(float));
+        }
+        powerToDb(in.data(), out.data(), CHUNK, 1.0f, -1000.0f);
+        for (int i = 0; i < CHUNK; i++) {
+            double e = fabs(out[i] - 10.0 * log10((double)in[i]));
+            if (e > maxError) { maxError = e; worst = in[i]; }
+        }
+    }
+    for (int e = -120; e <= 120; e++) {
+        for (int i = 0; i < CHUNK; i++) {
+            in[i] = ldexpf(1.0f + (float)i / CHUNK, e);
+        }
+        powerToDb(in.data(), out.data(), CHUNK, 1.0f, -1000.0f);
+        for (int i = 0; i < CHUNK; i++) {
+            double err = fabs(out[i] - 10.0 * log10((double)in[i]));
+            if (err > maxError) { maxError = err; worst = in[i]; }
+        }
+    }
+
+    bool ok = maxError <= POWER_TO_DB_MAX_ERROR;
+    printf("max |error| %.6f dB at power %g (bound %.4f dB): %s\n\n",
+           maxError, worst, POWER_TO_DB_MAX_ERROR, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static int runDb(int argc, char *argv[]) {
+    int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+
+    printf("Power -> dB kernel\n\n");
+    bool ok = dbErrorBound();
+
+    printf("%7s %14s %14s %14s %9s\n", "bins", "legacy ns/bin", "log10 ns/bin",
+           "fast ns/bin", "speedup");
+    for (int bins = 1024; bins <= 65536; bins *= 2) {
+        int n = bins * 2;
+        std::vector<double> hc(n), power(bins + 1), db(bins + 1), magnitudes;
+        unsigned seed = 3;
+        for (int i = 0; i < n; i++) {
+            seed = seed * 1103515245u + 12345u;
+            hc[i] = ((seed >> 8) & 0xFFFF) * 0.01;
+        }
+        accumulatePower(hc.data(), n, power.data(), PowerReplace);
+        const float scale = 4.0f / (float)((n * 0.5) * (n * 0.5) * 0.81);
+
+        Result legacy = timeFrames(iterations, [&](int) {
+            legacyDb(hc.data(), n, magnitudes);
+            g_sink = magnitudes[bins / 2];
+        });
+        // Exact, but already on power with preallocated output
+        Result exact = timeFrames(iterations, [&](int) {
+            for (int i = 1; i < bins; i++) {
+                double v = 10.0 * log10(power[i] * scale);
+                db[i] = v > -80.0 ? v : -80.0;
+            }
+            g_sink = db[bins / 2];
+        });
+        Result fast = timeFrames(iterations, [&](int) {
+            powerToDb(power.data() + 1, db.data() + 1, bins - 1, scale, -80.0f);
+            g_sink = db[bins / 2];
+        });
+
+        printf("%7d %14.2f %14.2f %14.2f %8.1fx\n", bins, legacy.nsPerFrame / bins,
+               exact.nsPerFrame / bins, fast.nsPerFrame / bins,
+               legacy.nsPerFrame / fast.nsPerFrame);
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Allocation count of the spectrum publish path
+// ---------------------------------------------------------------------------
+
+// What DSPThread did before pooling: a fresh SpectrumData per spectrum with
+// both vectors appended bin by bin
+struct LegacySpectrum {
+    std::vector<double> frequencies;
+    std::vector<double> magnitudes;
+};
+
+static int runAlloc(int argc, char *argv[]) {
+    int n = argc > 2 ? atoi(argv[2]) : 1024;
+    int spectra = argc > 3 ? atoi(argv[3]) : 100000;
+    const int bins = n / 2;
+
+    std::vector<double> power(bins + 1);
+    for (int i = 0; i <= bins; i++) {
+        power[i] = 1e3 / (1 + i);
+    }
+
+    printf("Spectrum publish path, FFT %d (%d bins), %d spectra\n\n", n, bins, spectra);
+
+    // Legacy: allocations per spectrum
+    uint64_t before = g_allocations;
+    for (int s = 0; s < 1000; s++) {
+        LegacySpectrum data;
+        for (int i = 1; i <= bins; i++) {
+            data.magnitudes.push_back(10.0 * log10(power[i]));
+            data.frequencies.push_back(i * 48000.0 / n);
+        }
+        g_sink = data.magnitudes[bins / 2];
+    }
+    double legacyPerSpectrum = (g_allocations - before) / 1000.0;
+
+    // Pooled: producer publishes like DSPThread::publishSpectrum, a reader
+    // thread takes the latest like MainWindow::refreshPlot at ~1 kHz
+    SpectrumFramePool pool(8);
+    SpectrumBus bus;
+    SpectrumSubscriptionPtr ui = bus.subscribe("ui", SpectrumSubscription::LatestOnly);
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> displayed(0);
+
+    std::thread reader([&] {
+        while (running) {
+            SpectrumFrameRef frame = ui->take();
+            if (frame) {
+                g_sink = frame->magnitudes[0];
+                displayed++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    uint64_t sequence = 0;
+    auto publish = [&] {
+        SpectrumFrameRef frame = pool.acquire(bins);
+        frame->axis = pool.axis(48000, n);
+        frame->sequence = sequence++;
+        powerToDb(power.data() + 1, frame->magnitudes, bins, 1.0f, -80.0f);
+        bus.publish(frame);
+    };
+
+    // Warm up: the axis, the frames' storage and any pool growth happen
+    // here; DSPThread reserves on every FFT size change the same way
+    pool.reserve(bins);
+    for (int s = 0; s < 1000; s++) {
+        publish();
+    }
+    uint64_t steadyStart = g_allocations;
+    uint64_t storageStart = pool.storageAllocations();
+    uint64_t grownStart = pool.grown();
+
+    for (int s = 0; s < spectra; s++) {
+        publish();
+        if (s % 64 == 0) {
+            std::this_thread::yield();   // let the reader interleave
+        }
+    }
+
+    uint64_t steady = (g_allocations - steadyStart) + (pool.storageAllocations() - storageStart);
+    running = false;
+    reader.join();
+
+    printf("legacy SpectrumData         %8.1f heap allocations/spectrum\n", legacyPerSpectrum);
+    printf("pooled, steady state        %8llu heap allocations in %d spectra\n",
+           (unsigned long long)steady, spectra);
+    printf("pool: %d frames (%llu grown after warm-up), %llu shown by reader\n",
+           pool.size(), (unsigned long long)(pool.grown() - grownStart),
+           (unsigned long long)displayed.load());
+    printf("\n%s\n", steady == 0 ? "ok: zero allocations" : "FAIL: steady state allocates");
+    return steady == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Subscriber isolation on the spectrum bus
+// ---------------------------------------------------------------------------
+
+static double percentile(std::vector<uint64_t> &samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    return samples[(size_t)(p * (samples.size() - 1))];
+}
+
+// Publishes `spectra` frames and returns per-publish times in ns
+static std::vector<uint64_t> timePublishes(SpectrumFramePool &pool, SpectrumBus &bus,
+                                           int spectra, int bins) {
+    std::vector<uint64_t> times(spectra);
+    for (int s = 0; s < spectra; s++) {
+        auto start = std::chrono::steady_clock::now();
+        SpectrumFrameRef frame = pool.acquire(bins);
+        frame->axis = pool.axis(48000, 2 * bins);
+        frame->sequence = s;
+        frame->magnitudes[0] = s;
+        bus.publish(frame);
+        frame.reset();
+        times[s] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+        // ~20 kHz: far above the real spectra rate, slow enough for the
+        // consumers to interleave
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return times;
+}
+
+static int runBus(int argc, char *argv[]) {
+    int spectra = argc > 2 ? atoi(argv[2]) : 20000;
+    const int bins = 512;
+    bool ok = true;
+
+    printf("Spectrum bus, %d spectra of %d bins\n\n", spectra, bins);
+
+    // Baseline: one latest-only subscriber nobody reads
+    SpectrumFramePool basePool(8);
+    SpectrumBus baseBus;
+    SpectrumSubscriptionPtr idle = baseBus.subscribe("idle", SpectrumSubscription::LatestOnly);
+    std::vector<uint64_t> base = timePublishes(basePool, baseBus, spectra, bins);
+
+    // UI polling at 1 kHz, a metrics queue nobody drains, a recorder that
+    // needs 200 us per frame (slower than the publisher)
+    SpectrumFramePool pool(8);
+    SpectrumBus bus;
+    SpectrumSubscriptionPtr ui = bus.subscribe("ui", SpectrumSubscription::LatestOnly);
+    SpectrumSubscriptionPtr metrics = bus.subscribe("metrics", SpectrumSubscription::Queue, 4);
+    SpectrumSubscriptionPtr recorder = bus.subscribe("recorder", SpectrumSubscription::Blocking, 64);
+    std::atomic<bool> running(true);
+    uint64_t uiFrames = 0, recorded = 0;
+    bool recorderInOrder = true;
+
+    std::thread uiThread([&] {
+        while (running) {
+            if (ui->take()) {
+                uiFrames++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::thread recorderThread([&] {
+        double last = -1.0;
+        for (;;) {
+            SpectrumFrameRef frame = recorder->wait(100);
+            if (!frame) {
+                if (recorder->closed()) {
+                    break;
+                }
+                continue;
+            }
+            recorderInOrder &= frame->magnitudes[0] > last;
+            last = frame->magnitudes[0];
+            recorded++;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    std::vector<uint64_t> loaded = timePublishes(pool, bus, spectra, bins);
+    bus.close();
+    recorderThread.join();
+    running = false;
+    uiThread.join();
+
+    printf("publish, 1 idle subscriber      p50 %6.0f ns  p99 %6.0f ns  max %7.0f ns\n",
+           percentile(base, 0.5), percentile(base, 0.99), percentile(base, 1.0));
+    printf("publish, ui + stalled + slow    p50 %6.0f ns  p99 %6.0f ns  max %7.0f ns\n\n",
+           percentile(loaded, 0.5), percentile(loaded, 0.99), percentile(loaded, 1.0));
+
+    for (const SpectrumSubscriptionPtr &subscription : bus.subscriptions()) {
+        printf("%-10s offered %6llu  dropped %6llu\n", subscription->name().c_str(),
+               (unsigned long long)subscription->offered(),
+               (unsigned long long)subscription->dropped());
+        ok &= subscription->offered() == (uint64_t)spectra;
+    }
+    printf("ui took %llu, recorder wrote %llu (%s); pool grew to %d frames\n",
+           (unsigned long long)uiFrames, (unsigned long long)recorded,
+           recorderInOrder ? "in order" : "OUT OF ORDER", pool.size());
+
+    ok &= recorderInOrder;
+    ok &= recorded + recorder->dropped() == (uint64_t)spectra;
+    ok &= metrics->dropped() == (uint64_t)spectra - 4;
+    // A stalled consumer may cost the publisher a queue push, never a wait
+    ok &= percentile(loaded, 0.99) < percentile(base, 0.99) + 50000.0;
+
+    printf("\n%s\n", ok ? "ok: subscribers isolated" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Pixel-column decimation on the log frequency axis
+// ---------------------------------------------------------------------------
+
+struct PlotPoint {
+    double x, y;
+    void setX(double v) { x = v; }
+    void setY(double v) { y = v; }
+};
+
+static int runDecimate(int argc, char *argv[]) {
+    const int width = argc > 2 ? atoi(argv[2]) : 800;
+    // MainWindow's x axis: log, 31.5 Hz .. 20 kHz
+    const double lower = 31.5, upper = 20000.0;
+    bool ok = true;
+
+    printf("Log axis %g..%g Hz over %d px\n\n", lower, upper, width);
+    printf("  FFT    visible   columns   points   pts/col   us/decimate   envelope\n");
+
+    for (int n = 256; n <= 65536; n *= 2) {
+        const int bins = n / 2;
+        std::vector<double> binX(bins);
+        for (int i = 0; i < bins; i++) {
+            double f = (i + 1) * 48000.0 / n;
+            binX[i] = log(f / lower) / log(upper / lower) * width;
+        }
+        int first = 0, last = bins - 1;
+        while (first < bins && binX[first] < 0.0) first++;
+        while (last >= first && binX[last] > width) last--;
+        first = std::max(0, first - 1);
+        last = std::min(bins - 1, last + 1);
+
+        ColumnDecimator decimator;
+        decimator.build(binX.data(), first, last);
+
+        // Noise floor with a few sharp single-bin peaks
+        std::vector<double> db(bins);
+        unsigned seed = n;
+        for (int i = 0; i < bins; i++) {
+            seed = seed * 1103515245u + 12345u;
+            db[i] = -70.0 + ((seed >> 16) % 1000) / 100.0;
+        }
+        for (int i = bins / 7; i < bins; i += bins / 7) {
+            db[i] = -3.0;
+        }
+
+        std::vector<PlotPoint> points(decimator.maxPoints());
+        int count = decimator.decimate(db.data(), points.data());
+
+        // Envelope: every column's true min/max appears among its points
+        bool envelope = true;
+        for (int i = first; i <= last; ) {
+            double pixel = floor(binX[i]);
+            double lo = db[i], hi = db[i];
+            int j = i;
+            while (j <= last && floor(binX[j]) == pixel) {
+                lo = std::min(lo, db[j]);
+                hi = std::max(hi, db[j]);
+                j++;
+            }
+            bool hasLo = false, hasHi = false;
+            for (int k = 0; k < count; k++) {
+                if (floor(points[k].x) != pixel) continue;
+                hasLo |= points[k].y == lo;
+                hasHi |= points[k].y == hi;
+            }
+            envelope &= hasLo && hasHi;
+            i = j;
+        }
+
+        const int iterations = 2000;
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            g_sink = decimator.decimate(db.data(), points.data());
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count() / iterations;
+
+        bool bounded = count <= 4 * (width + 2) && count <= decimator.maxPoints();
+        printf("%6d   %7d   %7d   %6d   %7.2f   %11.2f   %s\n", n, last - first + 1,
+               decimator.columns(), count, (double)count / decimator.columns(), us,
+               envelope ? "ok" : "LOST");
+        ok &= envelope && bounded;
+    }
+
+    printf("\n%s\n", ok ? "ok: <= 4 points per column, min/max kept"
+                        : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int runPersistence(int argc, char *argv[]) {
+    const int width = argc > 2 ? atoi(argv[2]) : 800;
+    const int height = argc > 3 ? atoi(argv[3]) : 300;
+    const int halfLife = 48;
+    // MainWindow's axes: log 31.5 Hz .. 20 kHz, -80 .. 0 dB
+    const double lower = 31.5, upper = 20000.0;
+    bool ok = true;
+
+    printf("Persistence grid %d x %d, half-life %d spectra\n\n", width, height, halfLife);
+    printf("  FFT   us/spectrum   tone cell   after half-life   fade\n");
+
+    for (int n = 256; n <= 65536; n *= 2) {
+        const int bins = n / 2;
+        std::vector<double> binX(bins);
+        for (int i = 0; i < bins; i++) {
+            double f = (i + 1) * 48000.0 / n;
+            binX[i] = log(f / lower) / log(upper / lower) * width;
+        }
+
+        PersistenceGrid grid;
+        grid.resize(width, height);
+        grid.setValueRange(-80.0, 0.0);
+        grid.setHalfLife(halfLife);
+        grid.setBinX(binX.data(), bins);
+
+        // Noise floor with a -6 dB tone at 1 kHz
+        const int toneBin = (int)lround(1000.0 * n / 48000.0) - 1;
+        std::vector<double> db(bins);
+        unsigned seed = n;
+        for (int i = 0; i < bins; i++) {
+            seed = seed * 1103515245u + 12345u;
+            db[i] = -70.0 + ((seed >> 16) % 1000) / 100.0;
+        }
+        db[toneBin] = -6.0;
+
+        const int iterations = 2000;
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            grid.add(db.data());
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count() / iterations;
+
+        // Top of the tone: row of -6 dB in the tone's column
+        const int x = (int)floor(binX[toneBin]);
+        const int y = (int)floor(6.0 * height / 80.0);
+        const int steady = grid.column(x)[y];
+
+        // Nothing on screen from here on: the cell should only decay
+        std::vector<double> silent(bins, -200.0);
+        for (int it = 0; it < halfLife; it++) {
+            grid.add(silent.data());
+        }
+        const int faded = grid.column(x)[y];
+        const double ratio = steady ? (double)faded / steady : 0.0;
+
+        // Between 3/4 of full scale (just decayed) and full scale
+        bool saturated = steady >= 0xFFFF * 3 / 4 - grid.weight();
+        bool fades = ratio > 0.35 && ratio < 0.65;
+        printf("%6d   %11.2f   %9d   %15d   %4.2f %s\n", n, us, steady, faded, ratio,
+               saturated && fades ? "ok" : "FAIL");
+        ok &= saturated && fades;
+    }
+
+    printf("\n%s\n", ok ? "ok: steady hits saturate, counts halve per half-life" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+static int runProfile(int argc, char *argv[]) {
+    const int samples = argc > 2 ? atoi(argv[2]) : 2000000;
+    const int writers = 3;
+    bool ok = true;
+
+    // Per call, as the DSP thread would see it
+    Profiler::registerThread("bench");
+    const int calls = 1000000;
+    double ns[2];
+    uint64_t allocations = g_allocations.load();
+    for (int on = 0; on < 2; on++) {
+        Profiler::setEnabled(on != 0);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) {
+            ProfileTimer timer(Profiler::FFT);
+        }
+        ns[on] = std::chrono::duration<double, std::nano>(
+                 std::chrono::steady_clock::now() - start).count() / calls;
+    }
+    allocations = g_allocations.load() - allocations;
+    printf("ProfileTimer: %.1f ns off, %.1f ns on (two clock reads + record), %llu allocations\n\n",
+           ns[0], ns[1], (unsigned long long)allocations);
+    ok &= allocations == 0;
+
+    // Writers record known durations while the reader collects flat out
+    Profiler::Snapshot snapshot;
+    Profiler::collect(&snapshot);   // baseline: drops the timing loop above
+    std::atomic<int> running(writers);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; t++) {
+        threads.push_back(std::thread([&, t] {
+            char name[16];
+            snprintf(name, sizeof(name), "writer %d", t);
+            Profiler::registerThread(name);
+            for (int i = 0; i < samples; i++) {
+                // 1 .. 1000 us, all stages
+                Profiler::record((Profiler::Stage)(i % Profiler::NUM_STAGES),
+                                 (uint64_t)(1 + i % 1000) * 1000);
+            }
+            running--;
+        }));
+    }
+    uint64_t counted = 0, collects = 0, maxNs = 0;
+    bool done = false;
+    while (!done) {
+        done = running == 0;   // one more collect after the writers finish
+        Profiler::collect(&snapshot);
+        collects++;
+        for (int s = 0; s < Profiler::NUM_STAGES; s++) {
+            counted += snapshot.stages[s].count();
+            maxNs = std::max(maxNs, snapshot.stages[s].maxNs());
+        }
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    const uint64_t expected = (uint64_t)writers * samples;
+    bool exact = counted == expected;
+    bool maxKept = maxNs == 1000000;
+    printf("%d writers x %d samples, %llu collects: %llu counted %s, max %.0f us %s\n",
+           writers, samples, (unsigned long long)collects, (unsigned long long)counted,
+           exact ? "ok" : "MISMATCH", maxNs / 1e3, maxKept ? "ok" : "LOST");
+    ok &= exact && maxKept;
+
+    printf("\n%s\n", ok ? "ok: every sample counted once under concurrent collects" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// Kernel suite: every per-frame and per-spectrum kernel DSPThread and the
+// renderers run, over all FFT sizes and both precisions
+// ---------------------------------------------------------------------------
+
+template <typename T> struct FFTWApi;
+
+template <> struct FFTWApi<double> {
+    typedef fftw_plan Plan;
+    static const char* name() { return "f64"; }
+    static double* alloc(int n) { return (double*)fftw_malloc(sizeof(double) * n); }
+    static void release(double *p) { fftw_free(p); }
+    static Plan plan(int n, double *in, double *out, unsigned flags) {
+        return fftw_plan_r2r_1d(n, in, out, FFTW_R2HC, flags);
+    }
+    static void execute(Plan plan, double *in, double *out) { fftw_execute_r2r(plan, in, out); }
+    static void destroy(Plan plan) { fftw_destroy_plan(plan); }
+};
+
+template <> struct FFTWApi<float> {
+    typedef fftwf_plan Plan;
+    static const char* name() { return "f32"; }
+    static float* alloc(int n) { return (float*)fftwf_malloc(sizeof(float) * n); }
+    static void release(float *p) { fftwf_free(p); }
+    static Plan plan(int n, float *in, float *out, unsigned flags) {
+        return fftwf_plan_r2r_1d(n, in, out, FFTW_R2HC, flags);
+    }
+    static void execute(Plan plan, float *in, float *out) { fftwf_execute_r2r(plan, in, out); }
+    static void destroy(Plan plan) { fftwf_destroy_plan(plan); }
+};
+
+struct SuiteRow {
+    const char *kernel;
+    const char *precision;
+    int n;
+    int iterations;
+    Result result;
+};
+
+// About 20 ms of work per kernel and size, whatever the machine
+template <typename F>
+static SuiteRow timeKernel(const char *kernel, const char *precision, int n, F frame) {
+    const double targetNs = 20e6;
+    Result probe = timeFrames(3, frame);
+    int iterations = (int)std::max(5.0, std::min(200000.0, targetNs / std::max(probe.nsPerFrame, 1.0)));
+
+    SuiteRow row;
+    row.kernel = kernel;
+    row.precision = precision;
+    row.n = n;
+    row.iterations = iterations;
+    row.result = timeFrames(iterations, frame);
+    return row;
+}
+
+template <typename T>
+static void suitePrecision(int n, unsigned planFlags, std::vector<SuiteRow> *rows) {
+    typedef FFTWApi<T> Api;
+    std::vector<uint16_t> raw(n);
+    fillTestSignal(raw.data(), n);
+
+    T *window = Api::alloc(n);
+    T *input = Api::alloc(n);
+    T *output = Api::alloc(n);
+    T *power = Api::alloc(n / 2 + 1);
+    std::vector<double> db(n / 2);
+    typename Api::Plan plan = Api::plan(n, input, output, planFlags);
+    makeHannWindow(window, n, ADC_VOLTS_PER_CODE);
+
+    // In pipeline order, each on the previous one's real output
+    FrameStats stats;
+    rows->push_back(timeKernel("convert", Api::name(), n, [&](int) {
+        convertWindowFrame(raw.data(), window, input, n, &stats);
+    }));
+    rows->push_back(timeKernel("fft", Api::name(), n, [&](int) {
+        Api::execute(plan, input, output);
+    }));
+    accumulatePower(output, n, power, PowerReplace);
+    rows->push_back(timeKernel("power", Api::name(), n, [&](int) {
+        accumulatePower(output, n, power, PowerSum);
+    }));
+    // Summed power keeps growing; dB of a fresh frame, as published
+    accumulatePower(output, n, power, PowerReplace);
+    rows->push_back(timeKernel("db", Api::name(), n, [&](int) {
+        powerToDb(power + 1, db.data(), n / 2 - 1, 1e-3f, -80.0f);
+        powerToDb(power + n / 2, db.data() + n / 2 - 1, 1, 1e-3f, -80.0f);
+    }));
+    g_sink = db[n / 4] + stats.meanRaw;
+
+    Api::destroy(plan);
+    Api::release(window);
+    Api::release(input);
+    Api::release(output);
+    Api::release(power);
+}
+
+// Per spectrum, on the dB values: pixel-column decimation for the trace
+// and the persistence grid, on MainWindow's log axis at LCD size
+static void suiteDisplay(int n, std::vector<SuiteRow> *rows) {
+    const int width = 800, height = 300;
+    const double lower = 31.5, upper = 20000.0;
+    const int bins = n / 2;
+    std::vector<double> binX(bins), db(bins);
+    unsigned seed = n;
+    for (int i = 0; i < bins; i++) {
+        double f = (i + 1) * 48000.0 / n;
+        binX[i] = log(f / lower) / log(upper / lower) * width;
+        seed = seed * 1103515245u + 12345u;
+        db[i] = -70.0 + ((seed >> 16) % 1000) / 100.0;
+    }
+    int first = 0, last = bins - 1;
+    while (first < bins && binX[first] < 0.0) first++;
+    while (last >= first && binX[last] > width) last--;
+
+    ColumnDecimator decimator;
+    decimator.build(binX.data(), std::max(0, first - 1), std::min(bins - 1, last + 1));
+    std::vector<PlotPoint> points(decimator.maxPoints());
+    rows->push_back(timeKernel("decimate", "f64", n, [&](int) {
+        g_sink = decimator.decimate(db.data(), points.data());
+    }));
+
+    PersistenceGrid grid;
+    grid.resize(width, height);
+    grid.setValueRange(-80.0, 0.0);
+    grid.setHalfLife(48);
+    grid.setBinX(binX.data(), bins);
+    rows->push_back(timeKernel("persistence", "f64", n, [&](int) {
+        grid.add(db.data());
+    }));
+}
+
+static void jsonResult(const SuiteRow &row, bool last) {
+    const Result &r = row.result;
+    printf("    {\"kernel\": \"%s\", \"precision\": \"%s\", \"n\": %d, \"iterations\": %d, "
+           "\"ns_per_frame\": %.1f, \"ns_per_sample\": %.4f, \"frames_per_s\": %.1f, ",
+           row.kernel, row.precision, row.n, row.iterations,
+           r.nsPerFrame, r.nsPerFrame / row.n, 1e9 / r.nsPerFrame);
+    if (r.cyclesPerFrame > 0.0) {
+        printf("\"cycles_per_frame\": %.0f}", r.cyclesPerFrame);
+    } else {
+        printf("\"cycles_per_frame\": null}");
+    }
+    printf("%s\n", last ? "" : ",");
+}
+
+static int runSuite(int argc, char *argv[]) {
+    bool json = false;
+    bool measure = true;
+    int only = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--estimate") == 0) {
+            measure = false;
+        } else {
+            // Only sizes the sweep visits; anything else would run nothing
+            only = atoi(argv[i]);
+            if (only < 256 || only > 65536 || (only & (only - 1)) != 0) {
+                fprintf(stderr, "usage: %s suite [fft_size] [--json] [--estimate]\n"
+                        "fft_size: a power of two, 256-65536\n", argv[0]);
+                return 1;
+            }
+        }
+    }
+    const unsigned planFlags = measure ? FFTW_MEASURE : FFTW_ESTIMATE;
+
+    struct utsname host;
+    if (uname(&host) != 0) {
+        strcpy(host.machine, "unknown");
+        strcpy(host.release, "unknown");
+    }
+    CycleCounter probe;
+
+    if (!json) {
+        printf("DSP kernel suite on %s (%s), FFTW %s plans%s\n", host.machine, host.release,
+               measure ? "MEASURE" : "ESTIMATE",
+               probe.isAvailable() ? "" : ", cycle counter unavailable");
+        printf("ns/sample is per FFT input sample for every kernel\n\n");
+        printf("%-12s %4s %6s %12s %10s %12s %14s\n", "kernel", "prec", "N",
+               "ns/frame", "ns/sample", "frames/s", "cycles/frame");
+    }
+
+    std::vector<SuiteRow> rows;
+    for (int n = 256; n <= 65536; n *= 2) {
+        if (only && n != only) continue;
+        size_t begin = rows.size();
+        suitePrecision<double>(n, planFlags, &rows);
+        suitePrecision<float>(n, planFlags, &rows);
+        suiteDisplay(n, &rows);
+        if (json) {
+            continue;
+        }
+        for (size_t i = begin; i < rows.size(); i++) {
+            const Result &r = rows[i].result;
+            printf("%-12s %4s %6d %12.1f %10.3f %12.1f ", rows[i].kernel, rows[i].precision, n,
+                   r.nsPerFrame, r.nsPerFrame / n, 1e9 / r.nsPerFrame);
+            if (r.cyclesPerFrame > 0.0) {
+                printf("%14.0f\n", r.cyclesPerFrame);
+            } else {
+                printf("%14s\n", "-");
+            }
+        }
+        printf("\n");
+    }
+
+    if (json) {
+        printf("{\n");
+        printf("  \"benchmark\": \"dsp_bench suite\",\n");
+        printf("  \"host\": {\"machine\": \"%s\", \"kernel\": \"%s\", \"compiler\": \"%s\", "
+               "\"fftw\": \"%s\", \"plan_effort\": \"%s\", \"cycle_counter\": %s},\n",
+               host.machine, host.release, __VERSION__, fftw_version,
+               measure ? "measure" : "estimate", probe.isAvailable() ? "true" : "false");
+        printf("  \"results\": [\n");
+        for (size_t i = 0; i < rows.size(); i++) {
+            jsonResult(rows[i], i + 1 == rows.size());
+        }
+        printf("  ]\n}\n");
+    }
+    return rows.empty() ? 1 : 0;
+}
+
+static int runAccuracy(int argc, char *argv[]) {
+    int only = argc > 2 ? atoi(argv[2]) : 0;
+
+    printf("float32 vs float64 pipeline, -0.5 dBFS tone through a dithered 12-bit ADC\n");
+    printf("(12-bit SQNR is ~74 dB; per-bin floors drop a further 10*log10(N/2))\n\n");
+    printf("%6s %14s %16s %10s %16s\n", "N", "ADC floor dBFS", "f32 error dBFS",
+           "margin dB", "max |dB diff|");
+
+    bool ok = true;
+    for (int n = 256; n <= 65536; n *= 2) {
+        if (only && n != only) continue;
+        ok &= accuracyCheck(n);
+    }
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "accuracy") == 0) {
+        return runAccuracy(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "db") == 0) {
+        return runDb(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "alloc") == 0) {
+        return runAlloc(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "bus") == 0) {
+        return runBus(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "decimate") == 0) {
+        return runDecimate(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "persistence") == 0) {
+        return runPersistence(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "profile") == 0) {
+        return runProfile(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "suite") == 0) {
+        return runSuite(argc, argv);
+    }
+
+    int n = argc > 1 ? atoi(argv[1]) : 1024;
+    int iterations = argc > 2 ? atoi(argv[2]) : 20000;
+    if (n < 2 || iterations < 1) {
+        fprintf(stderr, "usage: %s [fft_size] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint16_t> raw(n);
+    std::vector<double> fftInput(n), window(n);
+    fillTestSignal(raw.data(), n);
+    makeHannWindow(window.data(), n, ADC_VOLTS_PER_CODE);
+
+    printf("Frame conversion, %d samples, %d iterations\n\n", n, iterations);
+
+    // Legacy path printed stats every 50th frame
+    Result before = timeFrames(iterations, [&](int it) {
+        legacyFrame(raw.data(), fftInput.data(), n, it % 50 == 0);
+        g_sink = fftInput[n / 2];
+    });
+    std::vector<double> legacyOut = fftInput;
+
+    Result after = timeFrames(iterations, [&](int) {
+        FrameStats stats;
+        convertWindowFrame(raw.data(), window.data(), fftInput.data(), n, &stats);
+        g_sink = fftInput[n / 2] + stats.meanRaw;
+    });
+
+    double maxError = 0.0;
+    for (int i = 0; i < n; i++) {
+        maxError = fmax(maxError, fabs(fftInput[i] - legacyOut[i]));
+    }
+
+    report("legacy (append/cos/copy)", before, n);
+    report("fused convertWindowFrame", after, n);
+    printf("\nspeedup: %.1fx   max |difference|: %.3g V\n",
+           before.nsPerFrame / after.nsPerFrame, maxError);
+    return 0;
+}
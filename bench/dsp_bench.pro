@@ -0,0 +1,45 @@
+# Standalone DSP kernel benchmark, no Qt needed (runs on the BeagleBone
+# without a display as well as on x86 dev boxes)
+TARGET = dsp_bench
+TEMPLATE = app
+
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+INCLUDEPATH += ..
+
+HEADERS = \
+    cyclecounter.h \
+    ../dspkernels.h \
+    ../spectrumdata.h \
+    ../triplebuffer.h \
+    ../spectrumbus.h \
+    ../columndecimator.h \
+    ../persistencegrid.h \
+    ../latencystats.h \
+    ../profiler.h
+
+SOURCES = \
+    dsp_bench.cpp \
+    ../dspkernels.cpp \
+    ../spectrumdata.cpp \
+    ../spectrumbus.cpp \
+    ../columndecimator.cpp \
+    ../persistencegrid.cpp \
+    ../latencystats.cpp \
+    ../profiler.cpp
+
+# FFTW double + float for the accuracy mode: the cross-built static libs
+# when present (BeagleBone), the system ones otherwise
+FFTW_ARM = /home/stopkins/lab5/fftw-arm
+exists($$FFTW_ARM/lib/libfftw3f.a) {
+    INCLUDEPATH += $$FFTW_ARM/include
+    LIBS += $$FFTW_ARM/lib/libfftw3.a $$FFTW_ARM/lib/libfftw3f.a
+} else {
+    LIBS += -lfftw3 -lfftw3f
+}
+
+LIBS += -lpthread -lm
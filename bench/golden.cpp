@@ -0,0 +1,499 @@
+// Golden-spectrum regression: known stimuli from SignalGeneratorSource go
+// through the real DSPThread - sample history, fused convert + window,
+// FFTW, power accumulation, dB scaling, frame pool and bus - and the
+// published spectra are checked against what each stimulus must read:
+//
+//   tone     bin-centred sine: level, bin frequency, leakage
+//   offbin   sine between two bins: Hann scalloping loss, flat-top level
+//   multi    three bin-centred tones 20 dB apart: each level and frequency
+//   white    white noise: per-bin level from sigma and the window's ENBW
+//   pink     pink noise: -3 dB/octave slope
+//   dcstep   DC step inside one frame: every other frame stays at the floor
+//   clip     sine past both ADC rails: fundamental and harmonics of the
+//            ideally clipped sine
+//
+// Expected values come from the stimulus (dBFS = 20*log10(Vpk / 0.9V)),
+// not from a previous run, so a change that moves them is a bug in the
+// pipeline or a deliberate change to this file. Every case runs in
+// float64 and float32, and the float32 spectrum must also match the
+// float64 one bin for bin within FLOAT_BUDGET_DB; a faster kernel or
+// another FFT backend has to pass the same way.
+//
+// Usage: golden [fft_size ...] [-v]    (default 256 4096 65536; -v keeps
+//                                      DSPThread's log output)
+
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include "dspthread.h"
+#include "samplesource.h"
+
+static const int SAMPLE_RATE = 48000;
+static const double FULL_SCALE_VOLTS = 0.9;   // 0 dBFS sine peak, as DSPThread scales it
+static const double FLOOR_DB = -80.0;         // DSPThread's dB floor
+static const double FLOAT_BUDGET_DB = 0.01;   // float32 vs float64, bins above -70 dB
+
+static double dbfs(double voltsPeak) {
+    return 20.0 * log10(voltsPeak / FULL_SCALE_VOLTS);
+}
+
+// ---------------------------------------------------------------------------
+// Running a stimulus through DSPThread
+// ---------------------------------------------------------------------------
+
+struct Run {
+    int n;
+    FFTPlanCache::Precision precision;
+    WindowTable::Type window;
+    int averages;
+    int spectra;
+    std::function<void(SignalGeneratorSource&)> stimulus;
+};
+
+struct Capture {
+    FrequencyAxisPtr axis;
+    double enbw;
+    std::vector<std::vector<double> > spectra;   // in publish order, none dropped
+
+    Capture() : enbw(0.0) {}
+    const std::vector<double>& last() const { return spectra.back(); }
+};
+
+static bool capture(const Run &run, Capture *out) {
+    DSPConfig config;
+    config.fftSize = run.n;
+    config.hopSize = run.n;   // frame k is exactly samples [k*n, (k+1)*n)
+    config.averages = run.averages;
+    config.precision = run.precision;
+    config.planEffort = FFTPlanCache::Estimate;
+    config.window = run.window;
+
+    // Not paced, and finite: DSPThread runs flat out and closes the bus at the end of the
+    // stimulus. Blocks divide the length, so no partial frame is left over.
+    SignalGeneratorSource *source = new SignalGeneratorSource(SAMPLE_RATE, std::min(run.n, 1024), false);
+    run.stimulus(*source);
+    source->setLength((uint64_t)run.n * run.averages * run.spectra);
+
+    DSPThread dsp(config);
+    dsp.setSampleSource(source);
+    // Deep enough for the whole run, so nothing is dropped however slow
+    // this side is
+    SpectrumSubscriptionPtr spectra =
+            dsp.bus().subscribe("golden", SpectrumSubscription::Blocking, run.spectra + 1);
+    dsp.start();
+
+    *out = Capture();
+    while (SpectrumFrameRef frame = spectra->wait(30000)) {
+        out->axis = frame->axis;
+        out->enbw = frame->enbw;
+        out->spectra.push_back(std::vector<double>(frame->magnitudes,
+                                                   frame->magnitudes + frame->numBins));
+    }
+    dsp.wait();
+    return (int)out->spectra.size() == run.spectra && spectra->dropped() == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Checks
+// ---------------------------------------------------------------------------
+
+class Checker {
+public:
+    Checker() : m_ok(true), m_failures(0) {}
+
+    void begin(const char *name, FFTPlanCache::Precision precision, int n) {
+        m_name = name;
+        m_precision = precision == FFTPlanCache::Float ? "f32" : "f64";
+        m_n = n;
+    }
+
+    void near(const char *what, double measured, double expected, double tolerance) {
+        bool ok = fabs(measured - expected) <= tolerance;
+        char limit[48];
+        snprintf(limit, sizeof(limit), "%.3f +- %.3f", expected, tolerance);
+        row(what, measured, limit, ok);
+    }
+    void atMost(const char *what, double measured, double limit) {
+        char text[48];
+        snprintf(text, sizeof(text), "<= %.3f", limit);
+        row(what, measured, text, measured <= limit);
+    }
+    void atLeast(const char *what, double measured, double limit) {
+        char text[48];
+        snprintf(text, sizeof(text), ">= %.3f", limit);
+        row(what, measured, text, measured >= limit);
+    }
+    void fail(const char *what) {
+        row(what, NAN, "pipeline", false);
+    }
+
+    bool ok() const { return m_ok; }
+    int failures() const { return m_failures; }
+
+private:
+    void row(const char *what, double measured, const char *limit, bool ok) {
+        printf("%-7s %-3s %6d  %-26s %10.3f  %-20s %s\n", m_name, m_precision, m_n, what,
+               measured, limit, ok ? "ok" : "FAIL");
+        m_ok &= ok;
+        m_failures += ok ? 0 : 1;
+    }
+
+    const char *m_name;
+    const char *m_precision;
+    int m_n;
+    bool m_ok;
+    int m_failures;
+};
+
+// magnitudes[i] is bin i + 1 (DC isn't published)
+static int peakIndex(const std::vector<double> &db, int from, int to) {
+    from = std::max(from, 0);
+    to = std::min(to, (int)db.size() - 1);
+    int peak = from;
+    for (int i = from; i <= to; i++) {
+        if (db[i] > db[peak]) peak = i;
+    }
+    return peak;
+}
+
+// Highest level more than `guard` bins from every listed bin
+static double maxAwayFrom(const std::vector<double> &db, const std::vector<int> &bins, int guard) {
+    double worst = FLOOR_DB;
+    for (int i = 0; i < (int)db.size(); i++) {
+        bool near = false;
+        for (int bin : bins) {
+            near |= abs(i - bin) <= guard;
+        }
+        if (!near) worst = std::max(worst, db[i]);
+    }
+    return worst;
+}
+
+// Bin a tone of `hz` lands in, as a magnitudes[] index
+static int binIndex(double hz, int n) {
+    return (int)lround(hz * n / SAMPLE_RATE) - 1;
+}
+
+// A bin-centred test frequency near 1 kHz
+static double centredHz(int n, int multiple = 1) {
+    int bin = std::max(2, (int)lround(1000.0 * n / SAMPLE_RATE)) * multiple;
+    return (double)bin * SAMPLE_RATE / n;
+}
+
+// Fourier series amplitude of harmonic h of a sine of `amplitude` clipped
+// at +-FULL_SCALE_VOLTS, by numerical integration over one period
+static double clippedHarmonic(double amplitude, int h) {
+    const int steps = 200000;
+    double sum = 0.0;
+    for (int i = 0; i < steps; i++) {
+        double x = 2.0 * M_PI * (i + 0.5) / steps;
+        double v = std::max(-FULL_SCALE_VOLTS, std::min(FULL_SCALE_VOLTS, amplitude * sin(x)));
+        sum += v * sin(h * x);
+    }
+    return fabs(2.0 * sum / steps);
+}
+
+// ---------------------------------------------------------------------------
+// Cases
+// ---------------------------------------------------------------------------
+
+static Run makeRun(int n, FFTPlanCache::Precision precision,
+                   const std::function<void(SignalGeneratorSource&)> &stimulus) {
+    Run run;
+    run.n = n;
+    run.precision = precision;
+    run.window = WindowTable::Hann;
+    run.averages = 1;
+    run.spectra = 3;
+    run.stimulus = stimulus;
+    return run;
+}
+
+// Each case checks one capture and hands it back for the float32 vs
+// float64 comparison
+typedef std::function<bool(int n, FFTPlanCache::Precision precision, Checker &checker,
+                           Capture *capture)> Case;
+
+static bool toneCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const double hz = centredHz(n), volts = 0.45;
+    checker.begin("tone", precision, n);
+    if (!capture(makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        gen.addTone(hz, volts);
+    }), out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    const std::vector<double> &db = out->last();
+    int peak = peakIndex(db, 0, (int)db.size() - 1);
+    checker.near("level dBFS", db[peak], dbfs(volts), 0.05);
+    checker.near("peak frequency Hz", out->axis->data()[peak], hz, 1e-6);
+    // Hann's main lobe is +-2 bins; past it only the symmetric window's
+    // tiny leakage and 12-bit quantization spurs remain
+    checker.atMost("leakage dBFS beyond 3 bins", maxAwayFrom(db, { peak }, 3), -70.0);
+    return true;
+}
+
+static bool offBinCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const double hz = centredHz(n) + 0.5 * SAMPLE_RATE / n, volts = 0.45;
+    auto stimulus = [&](SignalGeneratorSource &gen) { gen.addTone(hz, volts); };
+    checker.begin("offbin", precision, n);
+
+    // Flat-top reads the true level wherever the tone falls
+    Run flatTop = makeRun(n, precision, stimulus);
+    flatTop.window = WindowTable::FlatTop;
+    Capture flat;
+    if (!capture(flatTop, &flat) || !capture(makeRun(n, precision, stimulus), out)) {
+        checker.fail("capture");
+        return false;
+    }
+    const std::vector<double> &db = out->last();
+    int peak = peakIndex(db, 0, (int)db.size() - 1);
+
+    // Hann halfway between bins: sinc(0.5) / (1 - 0.5^2) = -1.424 dB
+    checker.near("hann level dBFS", db[peak], dbfs(volts) - 1.4236, 0.05);
+    checker.near("hann peak bins from tone", fabs(out->axis->data()[peak] - hz) * n / SAMPLE_RATE,
+                 0.5, 1e-9);
+    checker.near("flattop level dBFS", flat.last()[peakIndex(flat.last(), 0, (int)db.size() - 1)],
+                 dbfs(volts), 0.05);
+    return true;
+}
+
+static bool multiToneCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const int multiples[3] = { 1, 4, 13 };
+    const double volts[3] = { 0.3, 0.03, 0.003 };
+    checker.begin("multi", precision, n);
+    if (!capture(makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        for (int t = 0; t < 3; t++) gen.addTone(centredHz(n, multiples[t]), volts[t]);
+    }), out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    const std::vector<double> &db = out->last();
+    std::vector<int> bins;
+    for (int t = 0; t < 3; t++) {
+        double hz = centredHz(n, multiples[t]);
+        int bin = binIndex(hz, n);
+        int peak = peakIndex(db, bin - 2, bin + 2);
+        char what[32];
+        snprintf(what, sizeof(what), "tone %d level dBFS", t + 1);
+        checker.near(what, db[peak], dbfs(volts[t]), 0.1);
+        snprintf(what, sizeof(what), "tone %d frequency Hz", t + 1);
+        checker.near(what, out->axis->data()[peak], hz, 1e-6);
+        bins.push_back(bin);
+    }
+    checker.atMost("leakage dBFS beyond 3 bins", maxAwayFrom(db, bins, 3), -70.0);
+    return true;
+}
+
+// Mean dB over the bins clear of DC (the per-frame DC removal eats into
+// the lowest ones) and Nyquist, over every captured spectrum
+static double meanDb(const Capture &capture, double fromHz, double toHz) {
+    double sum = 0.0;
+    int count = 0;
+    for (const std::vector<double> &db : capture.spectra) {
+        for (int i = 0; i < (int)db.size(); i++) {
+            double hz = capture.axis->data()[i];
+            if (hz >= fromHz && hz <= toHz) {
+                sum += db[i];
+                count++;
+            }
+        }
+    }
+    return count ? sum / count : NAN;
+}
+
+static bool whiteNoiseCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const double sigma = 0.05;
+    Run run = makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        gen.setNoise(sigma);
+        gen.setSeed(1);
+    });
+    run.averages = 64;
+    run.spectra = 2;
+    checker.begin("white", precision, n);
+    if (!capture(run, out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    // Per bin: 4 * sigma^2 * ENBW / (N * 0.9^2), as power; averaging 64
+    // frames leaves a -0.03 dB log bias and +-0.5 dB scatter per bin
+    double expected = 10.0 * log10(4.0 * sigma * sigma * out->enbw
+                                    / (n * FULL_SCALE_VOLTS * FULL_SCALE_VOLTS));
+    double binHz = (double)SAMPLE_RATE / n;
+    checker.near("mean bin level dBFS", meanDb(*out, 3 * binHz, SAMPLE_RATE / 2 - 2 * binHz),
+                 expected, 0.3);
+    return true;
+}
+
+static bool pinkNoiseCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    Run run = makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        gen.setPinkNoise(0.1);
+        gen.setSeed(2);
+    });
+    run.averages = 64;
+    run.spectra = 2;
+    checker.begin("pink", precision, n);
+    if (!capture(run, out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    // Least squares line through dB against octaves, 100 Hz .. 10 kHz
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    int count = 0;
+    for (const std::vector<double> &db : out->spectra) {
+        for (int i = 0; i < (int)db.size(); i++) {
+            double hz = out->axis->data()[i];
+            if (hz < 100.0 || hz > 10000.0) continue;
+            double x = log2(hz);
+            sx += x; sy += db[i]; sxx += x * x; sxy += x * db[i];
+            count++;
+        }
+    }
+    double slope = (count * sxy - sx * sy) / (count * sxx - sx * sx);
+    checker.near("slope dB/octave", slope, -10.0 * log10(2.0), 0.25);
+    return true;
+}
+
+static bool dcStepCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const int stepFrame = 5;
+    Run run = makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        gen.setDCStep((uint64_t)stepFrame * n + n / 2, 0.3);
+    });
+    run.spectra = 10;
+    checker.begin("dcstep", precision, n);
+    if (!capture(run, out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    // A constant input is removed exactly, step or not; only the frame
+    // that holds the step has anything in it
+    double quiet = FLOOR_DB;
+    for (int k = 0; k < (int)out->spectra.size(); k++) {
+        if (k != stepFrame) {
+            const std::vector<double> &db = out->spectra[k];
+            quiet = std::max(quiet, *std::max_element(db.begin(), db.end()));
+        }
+    }
+    const std::vector<double> &step = out->spectra[stepFrame];
+    checker.atMost("other frames max dBFS", quiet, FLOOR_DB + 0.5);
+    checker.atLeast("step frame max dBFS", *std::max_element(step.begin(), step.end()), -40.0);
+    return true;
+}
+
+static bool clipCase(int n, FFTPlanCache::Precision precision, Checker &checker, Capture *out) {
+    const double hz = centredHz(n), volts = 1.0;
+    checker.begin("clip", precision, n);
+    if (!capture(makeRun(n, precision, [&](SignalGeneratorSource &gen) {
+        gen.addTone(hz, volts);
+    }), out)) {
+        checker.fail("capture");
+        return false;
+    }
+
+    // Odd harmonics only: the rails are symmetric about the 0.9V bias
+    const std::vector<double> &db = out->last();
+    const int harmonics[4] = { 1, 2, 3, 5 };
+    for (int h : harmonics) {
+        int bin = binIndex(h * hz, n);
+        if (bin >= (int)db.size()) continue;
+        double level = db[peakIndex(db, bin - 1, bin + 1)];
+        char what[32];
+        snprintf(what, sizeof(what), "harmonic %d dBFS", h);
+        if (h % 2 == 0) {
+            checker.atMost(what, level, -60.0);
+        } else {
+            checker.near(what, level, dbfs(clippedHarmonic(volts, h)), h == 1 ? 0.1 : 0.3);
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+static void compareToDouble(const char *name, int n, const Capture &f64, const Capture &f32,
+                            Checker &checker) {
+    double worst = 0.0;
+    for (size_t k = 0; k < f64.spectra.size() && k < f32.spectra.size(); k++) {
+        for (size_t i = 0; i < f64.spectra[k].size(); i++) {
+            if (f64.spectra[k][i] > -70.0) {
+                worst = std::max(worst, fabs(f32.spectra[k][i] - f64.spectra[k][i]));
+            }
+        }
+    }
+    checker.begin(name, FFTPlanCache::Float, n);
+    checker.atMost("max |f32 - f64| dB", worst, FLOAT_BUDGET_DB);
+}
+
+static void quietMessages(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    if (type != QtDebugMsg) {
+        fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    std::vector<int> sizes;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else if (atoi(argv[i]) >= DSPThread::MIN_FFT_SIZE && atoi(argv[i]) <= DSPThread::MAX_FFT_SIZE) {
+            sizes.push_back(atoi(argv[i]));
+        } else {
+            fprintf(stderr, "usage: %s [fft_size ...] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes = { 256, 4096, 65536 };
+    }
+    if (!verbose) {
+        qInstallMessageHandler(quietMessages);
+    }
+
+    struct Named {
+        const char *name;
+        Case run;
+    };
+    const Named cases[] = {
+        { "tone", toneCase },
+        { "offbin", offBinCase },
+        { "multi", multiToneCase },
+        { "white", whiteNoiseCase },
+        { "pink", pinkNoiseCase },
+        { "dcstep", dcStepCase },
+        { "clip", clipCase },
+    };
+
+    printf("%-7s %-3s %6s  %-26s %10s  %-20s\n", "case", "", "N", "check", "measured", "expected");
+    Checker checker;
+    for (int n : sizes) {
+        for (const Named &c : cases) {
+            Capture f64, f32;
+            bool both = c.run(n, FFTPlanCache::Double, checker, &f64);
+            both &= c.run(n, FFTPlanCache::Float, checker, &f32);
+            if (both) {
+                compareToDouble(c.name, n, f64, f32, checker);
+            }
+        }
+    }
+
+    if (checker.ok()) {
+        printf("\nok: every stimulus within its golden tolerance, float32 within %.3f dB of float64\n",
+               FLOAT_BUDGET_DB);
+    } else {
+        printf("\nFAIL: %d checks out of tolerance\n", checker.failures());
+    }
+    return checker.ok() ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+# Golden-spectrum regression: synthetic stimuli through the real DSPThread
+# pipeline, checked against tolerances derived from the stimulus. QtCore
+# only, no display needed.
+TARGET = golden
+TEMPLATE = app
+
+QT = core
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+HEADERS = \
+    ../dspthread.h \
+    ../spectrumdata.h \
+    ../pruring.h \
+    ../samplesource.h \
+    ../bufferwaiter.h \
+    ../dspkernels.h \
+    ../samplehistory.h \
+    ../fftplancache.h \
+    ../windowtable.h \
+    ../triplebuffer.h \
+    ../spectrumbus.h \
+    ../captureclock.h \
+    ../latencystats.h \
+    ../profiler.h \
+    ../pru/pru_ring.h
+
+SOURCES = \
+    golden.cpp \
+    ../dspthread.cpp \
+    ../spectrumdata.cpp \
+    ../pruring.cpp \
+    ../samplesource.cpp \
+    ../bufferwaiter.cpp \
+    ../dspkernels.cpp \
+    ../samplehistory.cpp \
+    ../fftplancache.cpp \
+    ../windowtable.cpp \
+    ../spectrumbus.cpp \
+    ../captureclock.cpp \
+    ../latencystats.cpp \
+    ../profiler.cpp
+
+# Same FFTW as the application: the cross-built static libs when present
+# (BeagleBone), the system ones otherwise
+FFTW_ARM = /home/stopkins/lab5/fftw-arm
+exists($$FFTW_ARM/lib/libfftw3f.a) {
+    INCLUDEPATH += $$FFTW_ARM/include
+    LIBS += $$FFTW_ARM/lib/libfftw3.a $$FFTW_ARM/lib/libfftw3f.a
+} else {
+    LIBS += -lfftw3 -lfftw3f
+}
+
+LIBS += -lpthread -lm
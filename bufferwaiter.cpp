@@ -0,0 +1,129 @@
+#include "bufferwaiter.h"
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+// ---------------------------------------------------------------------------
+// PollWaiter
+// ---------------------------------------------------------------------------
+bool PollWaiter::wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) {
+    int wait_count = 0;
+    while (*writeSeq == seen) {
+        if (wait_count++ >= timeoutMs * 10) {
+            return false;
+        }
+        usleep(100);  // Wait 100us between checks
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// UioWaiter
+// ---------------------------------------------------------------------------
+UioWaiter::UioWaiter()
+        : m_fd(-1)
+{
+}
+
+UioWaiter::~UioWaiter() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool UioWaiter::open(const QString &device) {
+    m_device = device;
+    m_fd = ::open(device.toLocal8Bit().constData(), O_RDWR | O_CLOEXEC);
+    return m_fd >= 0;
+}
+
+bool UioWaiter::wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) {
+    // Re-enable (unmask) the interrupt before re-checking the counter, so
+    // an event raised after the check still wakes poll()
+    int32_t enable = 1;
+    if (write(m_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+        // uio_pruss has no irqcontrol; its line stays enabled
+    }
+
+    if (*writeSeq != seen) {
+        return true;
+    }
+
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    int ret = poll(&pfd, 1, timeoutMs);
+    if (ret <= 0) {
+        return false;
+    }
+
+    // Consume the event count so the next poll() blocks again
+    uint32_t count;
+    if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// FutexWaiter
+// ---------------------------------------------------------------------------
+bool FutexWaiter::wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) {
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    // Kernel compares *writeSeq with seen atomically before sleeping.
+    // Not FUTEX_PRIVATE_FLAG: the producer is another process.
+    long ret = syscall(SYS_futex, (uint32_t*)writeSeq, FUTEX_WAIT, seen, &timeout, nullptr, 0);
+    if (ret == 0 || errno == EAGAIN) {
+        return *writeSeq != seen;
+    }
+    return false;  // ETIMEDOUT or EINTR
+}
+
+void FutexWaiter::wake(volatile uint32_t *writeSeq) {
+    syscall(SYS_futex, (uint32_t*)writeSeq, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// ---------------------------------------------------------------------------
+// EventFdWaiter
+// ---------------------------------------------------------------------------
+EventFdWaiter::EventFdWaiter()
+        : m_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+}
+
+EventFdWaiter::~EventFdWaiter() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool EventFdWaiter::wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) {
+    if (*writeSeq != seen) {
+        return true;
+    }
+
+    // eventfd counts notifications, so one sent before poll() isn't lost
+    struct pollfd pfd = { m_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, timeoutMs) <= 0) {
+        return false;
+    }
+    uint64_t count;
+    if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+        return false;
+    }
+    return true;
+}
+
+void EventFdWaiter::notify() {
+    uint64_t one = 1;
+    if (write(m_fd, &one, sizeof(one)) != sizeof(one)) {
+        // Counter saturated: the consumer will wake anyway
+    }
+}
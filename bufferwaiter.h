@@ -0,0 +1,72 @@
+#ifndef BUFFERWAITER_H
+#define BUFFERWAITER_H
+
+#include <cstdint>
+#include <QString>
+
+// Blocks the consumer until the producer has published a new ring slot,
+// replacing the old usleep(100) polling loop. All backends are given the
+// ring's write_seq word and the value the caller last saw, and return
+// immediately if it has already moved on, so a wakeup that lands between
+// the caller's check and wait() is never lost.
+class BufferWaiter {
+public:
+    virtual ~BufferWaiter() {}
+
+    // True if write_seq changed (or an event arrived), false on timeout
+    virtual bool wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) = 0;
+    virtual QString name() const = 0;
+};
+
+// Fallback: check every 100us, like the original loop
+class PollWaiter : public BufferWaiter {
+public:
+    bool wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) override;
+    QString name() const override { return "poll"; }
+};
+
+// PRU system event delivered to the ARM through a UIO node
+// (uio_pruss, or uio_pdrv_genirq bound to PRU-ICSS evtout0 under remoteproc)
+class UioWaiter : public BufferWaiter {
+public:
+    UioWaiter();
+    ~UioWaiter();
+
+    bool open(const QString &device);
+    bool wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) override;
+    QString name() const override { return "uio " + m_device; }
+
+private:
+    int m_fd;
+    QString m_device;
+};
+
+// Cross-process futex on write_seq itself. Works for /dev/shm rings whose
+// producer calls FUTEX_WAKE after each publish (pru_sim does).
+class FutexWaiter : public BufferWaiter {
+public:
+    bool wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) override;
+    QString name() const override { return "futex"; }
+
+    // Producer side
+    static void wake(volatile uint32_t *writeSeq);
+};
+
+// In-process producer (e.g. a simulated PRU thread) signals an eventfd
+class EventFdWaiter : public BufferWaiter {
+public:
+    EventFdWaiter();
+    ~EventFdWaiter();
+
+    bool isValid() const { return m_fd >= 0; }
+    bool wait(const volatile uint32_t *writeSeq, uint32_t seen, int timeoutMs) override;
+    QString name() const override { return "eventfd"; }
+
+    // Producer side, safe from any thread
+    void notify();
+
+private:
+    int m_fd;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "captureclock.h"
+
+CaptureClock::CaptureClock()
+        : m_hz(0)
+        , m_refCount(0)
+        , m_refNs(0)
+        , m_bracketNs(0)
+        , m_roundStartNs(0)
+        , m_roundHasSample(false)
+{
+}
+
+void CaptureClock::reset(uint32_t hz) {
+    m_hz = hz;
+    m_refCount = 0;
+    m_refNs = 0;
+    m_bracketNs = 0;
+    m_roundStartNs = 0;
+    m_roundHasSample = false;
+}
+
+bool CaptureClock::due(uint64_t nowNs) const {
+    return m_hz != 0 && (m_refNs == 0 || nowNs - m_roundStartNs >= CORRELATION_INTERVAL_NS);
+}
+
+void CaptureClock::beginRound() {
+    m_roundHasSample = false;
+}
+
+void CaptureClock::addSample(uint64_t beforeNs, uint32_t count, uint64_t afterNs) {
+    if (afterNs < beforeNs) {
+        return;
+    }
+    uint64_t bracket = afterNs - beforeNs;
+    if (m_roundHasSample && bracket >= m_bracketNs) {
+        return;
+    }
+    m_roundHasSample = true;
+    m_roundStartNs = beforeNs;
+    m_bracketNs = bracket;
+    m_refCount = count;
+    m_refNs = beforeNs + bracket / 2;
+}
+
+uint64_t CaptureClock::toMonotonicNs(uint32_t count) const {
+    if (!valid()) {
+        return 0;
+    }
+    // Signed distance from the reference, so wraps in either direction
+    // resolve as long as count is within 2^31 ticks of it
+    int64_t ticks = (int32_t)(count - m_refCount);
+    return m_refNs + ticks * 1000000000LL / (int64_t)m_hz;
+}
@@ -0,0 +1,49 @@
+#ifndef CAPTURECLOCK_H
+#define CAPTURECLOCK_H
+
+#include <cstdint>
+
+// Maps a sample producer's free-running 32-bit clock (the PRU IEP counter,
+// see pru/pru_ring.h) onto CLOCK_MONOTONIC, so a slot's capture stamp can
+// be compared with times taken on the ARM.
+//
+// The consumer reads the producer's counter between two CLOCK_MONOTONIC
+// readings a few times and keeps the tightest bracket; its midpoint pairs
+// with the counter as the reference. Counts are converted relative to the
+// reference at the nominal rate and the pair is refreshed every 250 ms, so
+// crystal error (tens of ppm) adds at most a few microseconds and the
+// counter may wrap freely as long as stamps are within ~10 s of it.
+//
+// Qt-free; used by one thread.
+class CaptureClock {
+public:
+    CaptureClock();
+
+    // Forgets the reference; 0 Hz disables conversion
+    void reset(uint32_t hz);
+    uint32_t frequency() const { return m_hz; }
+
+    // Whether a new correlation round is due at nowNs
+    bool due(uint64_t nowNs) const;
+    // One round: `count` read between beforeNs and afterNs. The tightest
+    // bracket since the last beginRound() becomes the reference.
+    void beginRound();
+    void addSample(uint64_t beforeNs, uint32_t count, uint64_t afterNs);
+
+    bool valid() const { return m_hz != 0 && m_refNs != 0; }
+    // Uncertainty of the reference: half the bracket
+    uint64_t errorNs() const { return m_bracketNs / 2; }
+    uint64_t toMonotonicNs(uint32_t count) const;
+
+    static const uint64_t CORRELATION_INTERVAL_NS = 250000000ULL;
+
+private:
+    uint32_t m_hz;
+    uint32_t m_refCount;
+    uint64_t m_refNs;
+    uint64_t m_bracketNs;     // of the current reference
+    uint64_t m_roundStartNs;
+    bool m_roundHasSample;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "columndecimator.h"
+#include <cmath>
+
+void ColumnDecimator::build(const double *binX, int first, int last) {
+    m_columns.clear();
+    if (last < first) {
+        return;
+    }
+
+    m_columns.reserve(last - first + 1);
+    Column column;
+    column.x = binX[first];
+    column.start = first;
+    column.count = 1;
+    double pixel = std::floor(binX[first]);
+
+    for (int i = first + 1; i <= last; i++) {
+        double p = std::floor(binX[i]);
+        if (p == pixel) {
+            column.count++;
+            continue;
+        }
+        if (column.count > 1) {
+            column.x = pixel + 0.5;
+        }
+        m_columns.push_back(column);
+        column.x = binX[i];
+        column.start = i;
+        column.count = 1;
+        pixel = p;
+    }
+    if (column.count > 1) {
+        column.x = pixel + 0.5;
+    }
+    m_columns.push_back(column);
+}
@@ -0,0 +1,80 @@
+#ifndef COLUMNDECIMATOR_H
+#define COLUMNDECIMATOR_H
+
+#include <vector>
+
+// Reduces a spectrum to what a pixel column can show. On the log frequency
+// axis the bins are far apart at the low end and pile up hundreds to a
+// pixel at the high end, so uniform-density sampling (QCPGraph's adaptive
+// sampling) either keeps too much or loses peaks. Instead, consecutive
+// bins whose x falls in the same pixel column are grouped once per pixel
+// table (SpectrumTrace's LUT), and each replot emits per column:
+//
+//   one bin           the bin itself, at its exact x
+//   several bins      first, min, max, last in bin order, at the column x
+//
+// That keeps every peak and the line's entry and exit points, and bounds
+// the polyline to 4 points per column whatever the FFT size.
+//
+// Qt-free so bench/ can check the envelope and count the points.
+class ColumnDecimator {
+public:
+    // binX[first..last]: pixel x per bin, monotonic (either direction)
+    void build(const double *binX, int first, int last);
+
+    int columns() const { return (int)m_columns.size(); }
+    int maxPoints() const { return 4 * columns(); }
+
+    // Writes at most maxPoints() points, x in pixels and y in the input's
+    // unit (dB; the caller maps it to pixels), and returns the count.
+    // Point needs setX()/setY() (QPointF does).
+    template <typename Point>
+    int decimate(const double *db, Point *out) const;
+
+private:
+    struct Column {
+        double x;    // bin x for single-bin columns, column centre otherwise
+        int start;   // first bin
+        int count;
+    };
+
+    std::vector<Column> m_columns;
+};
+
+template <typename Point>
+int ColumnDecimator::decimate(const double *db, Point *out) const {
+    int n = 0;
+    for (const Column &column : m_columns) {
+        const int start = column.start;
+        const int end = start + column.count - 1;
+        if (column.count == 1) {
+            out[n].setX(column.x);
+            out[n].setY(db[start]);
+            n++;
+            continue;
+        }
+
+        int lo = start, hi = start;
+        for (int i = start + 1; i <= end; i++) {
+            if (db[i] < db[lo]) lo = i;
+            if (db[i] > db[hi]) hi = i;
+        }
+
+        // first, then min and max in bin order, then last; skipping
+        // repeats of the same bin
+        int picks[4] = { start, lo < hi ? lo : hi, lo < hi ? hi : lo, end };
+        int previous = -1;
+        for (int k = 0; k < 4; k++) {
+            if (picks[k] == previous) {
+                continue;
+            }
+            out[n].setX(column.x);
+            out[n].setY(db[picks[k]]);
+            n++;
+            previous = picks[k];
+        }
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "dspkernels.h"
+#include <cmath>
+#include <cstring>
+
+template <typename T>
+static void hannWindow(T *window, int n, double scale) {
+    for (int i = 0; i < n; i++) {
+        window[i] = (T)(scale * 0.5 * (1.0 - cos(2.0 * M_PI * i / (n - 1))));
+    }
+}
+
+void makeHannWindow(double *window, int n, double scale) {
+    hannWindow(window, n, scale);
+}
+
+void makeHannWindow(float *window, int n, double scale) {
+    hannWindow(window, n, scale);
+}
+
+template <typename T>
+static void convertWindow(const uint16_t * __restrict raw,
+                          const T * __restrict scaledWindow,
+                          T * __restrict out, int n, FrameStats *stats) {
+    // Pass 1: the only read of raw. Integer sum/min/max reductions and the
+    // convert+window multiply all vectorize.
+    uint32_t sum = 0;   // 4095 * 65536 still fits
+    uint16_t minRaw = 0xFFFF, maxRaw = 0;
+    for (int i = 0; i < n; i++) {
+        uint16_t r = raw[i];
+        sum += r;
+        minRaw = r < minRaw ? r : minRaw;
+        maxRaw = r > maxRaw ? r : maxRaw;
+        out[i] = (T)r * scaledWindow[i];
+    }
+
+    // Pass 2: remove DC. (raw - mean) * w == raw * w - mean * w
+    double mean = n > 0 ? (double)sum / n : 0.0;
+    const T m = (T)mean;
+    for (int i = 0; i < n; i++) {
+        out[i] -= m * scaledWindow[i];
+    }
+
+    if (stats) {
+        stats->minRaw = minRaw;
+        stats->maxRaw = maxRaw;
+        stats->meanRaw = mean;
+    }
+}
+
+void convertWindowFrame(const uint16_t *raw, const double *scaledWindow,
+                        double *out, int n, FrameStats *stats) {
+    convertWindow(raw, scaledWindow, out, n, stats);
+}
+
+void convertWindowFrame(const uint16_t *raw, const float *scaledWindow,
+                        float *out, int n, FrameStats *stats) {
+    convertWindow(raw, scaledWindow, out, n, stats);
+}
+
+template <typename T>
+static void foldPower(const T * __restrict hc, int n, T * __restrict power, PowerMode mode) {
+    // Half-complex: re[0..n/2], im[k] at hc[n-k]. DC and Nyquist are real.
+    const int half = n / 2;
+    const T * __restrict im = hc + n;   // im[-k] == hc[n-k]
+
+    T p0 = hc[0] * hc[0];
+    T pn = hc[half] * hc[half];
+
+    switch (mode) {
+    case PowerReplace:
+        power[0] = p0;
+        for (int k = 1; k < half; k++) {
+            power[k] = hc[k] * hc[k] + im[-k] * im[-k];
+        }
+        power[half] = pn;
+        break;
+    case PowerSum:
+        power[0] += p0;
+        for (int k = 1; k < half; k++) {
+            power[k] += hc[k] * hc[k] + im[-k] * im[-k];
+        }
+        power[half] += pn;
+        break;
+    case PowerMax:
+        power[0] = p0 > power[0] ? p0 : power[0];
+        for (int k = 1; k < half; k++) {
+            T p = hc[k] * hc[k] + im[-k] * im[-k];
+            power[k] = p > power[k] ? p : power[k];
+        }
+        power[half] = pn > power[half] ? pn : power[half];
+        break;
+    }
+}
+
+void accumulatePower(const double *halfComplex, int n, double *power, PowerMode mode) {
+    foldPower(halfComplex, n, power, mode);
+}
+
+void accumulatePower(const float *halfComplex, int n, float *power, PowerMode mode) {
+    foldPower(halfComplex, n, power, mode);
+}
+
+// log2(x) = exponent + log2(mantissa), mantissa in [1,2). log2(1 + t) is a
+// degree-4 minimax fit, max error 1.03e-4 (0.00031 dB), exact at t = 0.
+static inline float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float)((int)(bits >> 23) - 127);   // power is never negative
+
+    uint32_t mantissaBits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    memcpy(&m, &mantissaBits, sizeof(m));
+    float t = m - 1.0f;
+
+    float p = t * (1.43901598f + t * (-0.679954648f + t * (0.325618118f + t * -0.0847824365f)));
+    return exponent + p;
+}
+
+template <typename T>
+static void toDb(const T * __restrict power, double * __restrict db, int n,
+                 float scale, float floorDb) {
+    const float DB_PER_LOG2 = 3.01029996f;   // 10 * log10(2)
+    for (int i = 0; i < n; i++) {
+        float v = DB_PER_LOG2 * fastLog2((float)power[i] * scale);
+        db[i] = v > floorDb ? v : floorDb;
+    }
+}
+
+void powerToDb(const float *power, double *db, int n, float scale, float floorDb) {
+    toDb(power, db, n, scale, floorDb);
+}
+
+void powerToDb(const double *power, double *db, int n, float scale, float floorDb) {
+    toDb(power, db, n, scale, floorDb);
+}
@@ -0,0 +1,55 @@
+#ifndef DSPKERNELS_H
+#define DSPKERNELS_H
+
+#include <cstdint>
+
+// Per-frame hot loops. Kept free of Qt and heap allocation so the compiler
+// can vectorize them and bench/ can time them on their own.
+
+// ADC code -> volts (12-bit, 1.8V full scale)
+static const double ADC_VOLTS_PER_CODE = 1.8 / 4095.0;
+
+struct FrameStats {
+    uint16_t minRaw;
+    uint16_t maxRaw;
+    double meanRaw;
+};
+
+// Hann window pre-multiplied by `scale`, so converting and windowing a
+// sample is a single multiply
+void makeHannWindow(double *window, int n, double scale);
+void makeHannWindow(float *window, int n, double scale);
+
+// Raw ADC codes -> DC-removed, windowed FFT input:
+//   out[i] = (raw[i] - mean(raw)) * scaledWindow[i]
+// with scaledWindow from makeHannWindow(..., ADC_VOLTS_PER_CODE). raw is
+// read exactly once since it may be uncached PRU shared RAM; the DC
+// correction is a second pass over `out`, which is in cache by then.
+// Also fills in min/max/mean for the stats line if stats is non-null.
+void convertWindowFrame(const uint16_t *raw, const double *scaledWindow,
+                        double *out, int n, FrameStats *stats);
+
+// float32 versions: half the memory traffic, and NEON on the Cortex-A8
+// only vectorizes single precision
+void convertWindowFrame(const uint16_t *raw, const float *scaledWindow,
+                        float *out, int n, FrameStats *stats);
+
+// Fold one FFTW R2HC output of length n into per-bin power[0..n/2]:
+// |X|^2 replaces (first frame of a group), is summed, or is max-held
+enum PowerMode {
+    PowerReplace,
+    PowerSum,
+    PowerMax
+};
+void accumulatePower(const double *halfComplex, int n, double *power, PowerMode mode);
+void accumulatePower(const float *halfComplex, int n, float *power, PowerMode mode);
+
+// db[i] = max(10*log10(power[i] * scale), floorDb), straight from power so
+// there is no sqrt. Uses a polynomial log2 on the float bit pattern that
+// vectorizes; |error| <= POWER_TO_DB_MAX_ERROR over the whole float range
+// (see dsp_bench db). Writes exactly n values into caller-owned db.
+static const double POWER_TO_DB_MAX_ERROR = 0.001;
+void powerToDb(const float *power, double *db, int n, float scale, float floorDb);
+void powerToDb(const double *power, double *db, int n, float scale, float floorDb);
+
+#endif
@@ -1,278 +1,522 @@
 #include "dspthread.h"
+#include "profiler.h"
 #include <fftw3.h>
 #include <cmath>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <unistd.h>
+#include <ctime>
 #include <QDebug>
 
-#define PRU_SHARED_MEM 0x4A310000  // PRU shared memory address
-#define PRU_MEM_SIZE 0x3000        // 12KB
+// Bound by reference in qBound / qMin, so they need storage of their own
+const int DSPThread::MIN_FFT_SIZE;
+const int DSPThread::MAX_FFT_SIZE;
 
-DSPThread::DSPThread(QObject *parent)
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+DSPThread::DSPThread(const DSPConfig &config, QObject *parent)
         : QThread(parent)
+        , m_source(nullptr)
+        , m_sampleRate(48000)
+        , m_nextFrameStart(0)
+        , m_lastDroppedBlocks(0)
+        , m_samplesSkipped(0)
+        , m_stuckCount(0)
+        , m_statsWritten(0)
+        , m_statsSkipped(0)
         , m_running(false)
-        , m_pruBuffer(nullptr)
-        , m_pruMemFd(-1)
+        , m_sourceFailed(false)
+        , m_planCache(nullptr)
+        , m_requestedFFTSize(0)
         , m_fftPlan(nullptr)
-        , m_fftInput(nullptr)
-        , m_fftOutput(nullptr)
+        , m_singlePrecision(config.precision == FFTPlanCache::Float)
+        , m_windowChanged(false)
+        , m_framesInGroup(0)
+        , m_framesComputed(0)
+        , m_spectraPublished(0)
+        , m_busyNs(0)
+        , m_statsStartNs(0)
+        , m_framePool(8)
+        , m_sequence(0)
+        , m_lastBlockNs(0)
+        , m_frameStartNs(0)
+        , m_frameConvertedNs(0)
+        , m_lastFrameEnd(0)
+        , m_config(config)
+        , m_fftSize(0)
+        , m_hopSize(1)
+        , m_averages(1)
 {
-    initFFT();
+    m_requestedFFTSize = qBound(MIN_FFT_SIZE, config.fftSize, MAX_FFT_SIZE);
+    m_lastFrameStats.minRaw = m_lastFrameStats.maxRaw = 0;
+    m_lastFrameStats.meanRaw = 0.0;
+
+    // Loads wisdom now; the first plan is made at the start of run()
+    m_planCache = new FFTPlanCache(config.precision, config.planEffort, config.wisdomPath);
 }
 
 DSPThread::~DSPThread() {
     stop();
     cleanupFFT();
-    unmapPRUMemory();
+    delete m_planCache;
+    if (m_source) {
+        m_source->close();
+        delete m_source;
+    }
 }
 
-void DSPThread::initFFT() {
-    m_fftInput = (double*)fftw_malloc(sizeof(double) * FFT_SIZE);
-    m_fftOutput = (double*)fftw_malloc(sizeof(double) * FFT_SIZE);
+void DSPThread::setSampleSource(SampleSource *source) {
+    delete m_source;
+    m_source = source;
+}
 
-    // Create FFTW plan (real to half-complex)
-    m_fftPlan = fftw_plan_r2r_1d(FFT_SIZE, m_fftInput, m_fftOutput,
-                                 FFTW_R2HC, FFTW_ESTIMATE);
+void DSPThread::setFFTSize(int n) {
+    m_requestedFFTSize = qBound(MIN_FFT_SIZE, n, MAX_FFT_SIZE);
 }
 
-void DSPThread::cleanupFFT() {
-    if (m_fftPlan) {
-        fftw_destroy_plan((fftw_plan)m_fftPlan);
-        m_fftPlan = nullptr;
-    }
-    if (m_fftInput) {
-        fftw_free(m_fftInput);
-        m_fftInput = nullptr;
-    }
-    if (m_fftOutput) {
-        fftw_free(m_fftOutput);
-        m_fftOutput = nullptr;
-    }
+void DSPThread::setWindow(WindowTable::Type type, double parameter) {
+    QMutexLocker locker(&m_windowMutex);
+    m_config.window = type;
+    m_config.windowParameter = parameter;
+    m_windowChanged = true;
 }
 
-void* DSPThread::mapPRUMemory() {
-    m_pruMemFd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (m_pruMemFd < 0) {
-        return nullptr;
+void DSPThread::applyWindow() {
+    {
+        QMutexLocker locker(&m_windowMutex);
+        m_windowTable = WindowTable::get(m_config.window, m_fftSize, m_config.windowParameter);
+        m_windowChanged = false;
     }
 
-    void* mapped = mmap(0, PRU_MEM_SIZE, PROT_READ | PROT_WRITE,
-                        MAP_SHARED, m_pruMemFd, PRU_SHARED_MEM);
-
-    if (mapped == MAP_FAILED) {
-        close(m_pruMemFd);
-        m_pruMemFd = -1;
-        return nullptr;
+    if (m_singlePrecision) {
+        m_float.loadWindow(*m_windowTable);
+    } else {
+        m_double.loadWindow(*m_windowTable);
     }
 
-    m_pruBuffer = (uint16_t*)mapped;
-    return mapped;
+    // Frames under different windows don't average meaningfully
+    m_framesInGroup = 0;
 }
 
-void DSPThread::unmapPRUMemory() {
-    if (m_pruBuffer) {
-        munmap(m_pruBuffer, PRU_MEM_SIZE);
-        m_pruBuffer = nullptr;
+void DSPThread::applyFFTSize(int n, void *plan) {
+    cleanupFFT();
+
+    m_fftSize = n;
+    m_fftPlan = plan;
+    if (m_singlePrecision) {
+        m_float.allocate(m_fftSize);
+    } else {
+        m_double.allocate(m_fftSize);
     }
-    if (m_pruMemFd >= 0) {
-        close(m_pruMemFd);
-        m_pruMemFd = -1;
+    applyWindow();
+    m_framePool.reserve(m_fftSize / 2);
+
+    if (m_config.hopSize > 0) {
+        m_hopSize = qMin(m_config.hopSize, MAX_FFT_SIZE);
+    } else {
+        double overlap = qBound(0.0, m_config.overlap, 0.99);
+        m_hopSize = qMax(1, (int)lround(m_fftSize * (1.0 - overlap)));
     }
+
+    // Frames per displayed spectrum: auto keeps the publish rate near the
+    // display's needs however far the overlap pushes the frame rate
+    double frameRate = m_sampleRate / (double)m_hopSize;
+    m_averages = m_config.averages > 0
+                 ? m_config.averages
+                 : qMax(1, (int)ceil(frameRate / MAX_SPECTRA_RATE));
+
+    // Keep the samples we have if they still fit, so a size switch
+    // doesn't cost a gap in the stream
+    int capacity = qMax(2 * m_fftSize, m_fftSize + 8 * m_source->blockSize());
+    if (m_history.capacity() < capacity) {
+        m_history.reset(capacity);
+        m_nextFrameStart = 0;
+        m_statsWritten = 0;
+    }
+
+    qDebug() << "FFT" << m_fftSize << "hop" << m_hopSize
+             << "(" << (100.0 * qMax(0, m_fftSize - m_hopSize) / m_fftSize) << "% overlap )"
+             << "|" << m_averages
+             << (m_config.detector == DSPConfig::PeakHold ? "frame peak hold" : "frame average")
+             << "|" << m_windowTable->name() << "window, gain" << m_windowTable->coherentGain()
+             << "ENBW" << m_windowTable->enbw() << "bins";
 }
 
-QVector<double> DSPThread::readPRUSamples(int numSamples) {
-    QVector<double> samples;
+void DSPThread::cleanupFFT() {
+    // The plan belongs to m_planCache
+    m_fftPlan = nullptr;
+    m_double.release();
+    m_float.release();
+}
 
-    if (!m_pruBuffer) {
-        //fallback synthetic signal (10kHz sine wave)
-        for (int i = 0; i < numSamples; i++) {
-            double t = i / (double)SAMPLE_RATE;
-            double value = 0.9 + 0.3 * sin(2.0 * M_PI * 10000.0 * t);
-            samples.append(value);
+bool DSPThread::openSampleSource() {
+    if (!m_source && !m_config.sourceSpec.isEmpty()) {
+        QString error;
+        m_source = SampleSource::create(m_config.sourceSpec, &error);
+        if (!m_source) {
+            qWarning() << (m_config.testToneFallback ? "Ignoring --source:" : "Bad --source:")
+                       << error;
+            if (!m_config.testToneFallback) {
+                return false;
+            }
         }
-        return samples;
+    }
+    if (m_source) {
+        return m_source->open();
     }
 
-    // Get pointer to ready flag (at offset 0x1000)
-    volatile uint8_t* ready_flag = (volatile uint8_t*)((char*)m_pruBuffer + 0x1000);
-
-    // Track which buffer we read last to detect new data
-    static uint8_t last_buffer_read = 0;
-
-    // Wait for flag to change (indicating new buffer ready)
-    int wait_count = 0;
-    while (*ready_flag == last_buffer_read && wait_count < 1000) {
-        usleep(100);  // Wait 100us between checks
-        wait_count++;
+    // Default: real ADC data if the PRU is there, test signal otherwise
+    m_source = new PRUSampleSource;
+    if (m_source->open()) {
+        return true;
     }
+    if (!m_config.testToneFallback) {
+        return false;
+    }
+    qDebug() << "Could not map shared memory - using test signal";
+    delete m_source;
+    m_source = new SignalGeneratorSource(48000, 1024, true);
+    static_cast<SignalGeneratorSource*>(m_source)->addTone(10000.0, 0.3);
+    return m_source->open();
+}
+
+bool DSPThread::acquireBlock() {
+    // Sleep until the next block lands (up to 100ms)
+    const uint16_t* read_buffer = m_source->acquire(100);
+    Profiler::record(Profiler::Wait, m_source->lastWaitNs());
 
     // Occasional warning if stuck
-    static int stuck_count = 0;
-    if (*ready_flag == last_buffer_read) {
-        if (++stuck_count >= 10) {
-            qDebug() << "WARNING: Buffer flag stuck at" << *ready_flag;
-            stuck_count = 0;
+    if (!read_buffer) {
+        if (++m_stuckCount >= 10 && !m_source->atEnd()) {
+            qDebug() << "WARNING: no samples from" << m_source->description()
+                     << m_source->statusText();
+            m_stuckCount = 0;
         }
-    } else {
-        stuck_count = 0;
+        return false;
     }
+    m_stuckCount = 0;
+    m_lastBlockNs = m_source->lastCaptureNs() ? m_source->lastCaptureNs() : monotonicNs();
 
-    uint8_t buffer_ready = *ready_flag;  // 1=A, 2=B
-    last_buffer_read = buffer_ready;  // Remember which buffer we just read
-
-    // Skip buffers to reduce CPU load - only process every 2nd buffer
-    // This gives ~50 Hz update rate instead of ~90 Hz
-    static int skip_counter = 0;
-    if (++skip_counter < 2) {
-        // Skip this buffer, return last processed data
-        // (This is a quick hack - ideally we'd cache the last result)
-        // For now, just wait for next buffer
-        return readPRUSamples(numSamples);
+    // Blocks the source had to drop leave a hole in the stream
+    if (m_source->droppedBlocks() != m_lastDroppedBlocks) {
+        m_lastDroppedBlocks = m_source->droppedBlocks();
+        m_history.markDiscontinuity();
     }
-    skip_counter = 0;
 
-    volatile uint16_t* read_buffer = m_pruBuffer;  // Default to A
+    // Stitch onto the history; the source's buffer is read exactly once
+    m_history.append(read_buffer, m_source->blockSize());
+    m_source->release();
+    return true;
+}
 
-    if (buffer_ready == 2) {
-        // Buffer B is ready (at offset BUFFER_SIZE)
-        read_buffer = m_pruBuffer + 1024;
+const uint16_t* DSPThread::nextFrame() {
+    // Frames never straddle a hole in the stream, and if we fell so far
+    // behind that the history wrapped, resume at the oldest sample left
+    uint64_t earliest = qMax(m_history.discontinuity(), m_history.oldest());
+    if (m_nextFrameStart < earliest) {
+        m_samplesSkipped += earliest - m_nextFrameStart;
+        m_nextFrameStart = earliest;
     }
 
-    // Read from the ready buffer and calculate mean for DC removal
-    double sum = 0.0;
-    for (int i = 0; i < numSamples; i++) {
-        uint16_t raw = read_buffer[i];
-        double voltage = (raw / 4095.0) * 1.8;  // Convert to voltage
-        samples.append(voltage);
-        sum += voltage;
+    if (!m_history.contains(m_nextFrameStart, m_fftSize)) {
+        return nullptr;
     }
 
-    // Remove DC offset (critical for clean FFT)
-    double dc_offset = sum / numSamples;
-    for (int i = 0; i < numSamples; i++) {
-        samples[i] -= dc_offset;
-    }
+    const uint16_t *raw = m_history.data(m_nextFrameStart);
+    m_lastFrameEnd = m_nextFrameStart + m_fftSize;
+    m_nextFrameStart += m_hopSize;
+    return raw;
+}
 
-    // Calculate basic statistics for debugging (print occasionally to reduce overhead)
-    static int debug_counter = 0;
-    if (++debug_counter >= 50) {  // Print every 50 buffers (~1 second at 48 kHz)
-        uint16_t min_raw = 4095, max_raw = 0;
-        sum = 0.0;
-        for (int i = 0; i < numSamples; i++) {
-            uint16_t raw = read_buffer[i];
-            if (raw < min_raw) min_raw = raw;
-            if (raw > max_raw) max_raw = raw;
-            sum += raw;
-        }
-        double avg_raw = sum / numSamples;
+// Each precision's buffers come from its own library's allocator, so they
+// have the alignment that library's plans were made with (on the ARM build
+// only libfftw3f has NEON; libfftw3's fftw_malloc is plain malloc)
+template <typename T> struct FFTWMemory;
+
+template <> struct FFTWMemory<double> {
+    static double* alloc(size_t n) { return (double*)fftw_malloc(sizeof(double) * n); }
+    static void release(double *p) { fftw_free(p); }
+};
+
+template <> struct FFTWMemory<float> {
+    static float* alloc(size_t n) { return (float*)fftwf_malloc(sizeof(float) * n); }
+    static void release(float *p) { fftwf_free(p); }
+};
+
+template <typename T>
+void FFTBuffers<T>::allocate(int n) {
+    release();
+    input = FFTWMemory<T>::alloc(n);
+    output = FFTWMemory<T>::alloc(n);
+    window = FFTWMemory<T>::alloc(n);
+    power = FFTWMemory<T>::alloc(n / 2 + 1);
+}
 
-        qDebug() << "Buffer stats - Min:" << min_raw << "(" << (min_raw * 1.8 / 4095.0) << "V)"
-                 << "Max:" << max_raw << "(" << (max_raw * 1.8 / 4095.0) << "V)"
-                 << "Avg:" << avg_raw << "(" << (avg_raw * 1.8 / 4095.0) << "V)";
-        debug_counter = 0;
+template <typename T>
+void FFTBuffers<T>::loadWindow(const WindowTable &table) {
+    // Scaled once here; the per-frame kernel is then one multiply per sample
+    const double *w = table.coefficients();
+    for (int i = 0; i < table.size(); i++) {
+        window[i] = (T)(w[i] * ADC_VOLTS_PER_CODE);
     }
+}
 
-    // Don't clear flag - PRU will overwrite with next buffer ID
-    // We track last_buffer_read instead to detect changes
+template <typename T>
+void FFTBuffers<T>::release() {
+    FFTWMemory<T>::release(input);
+    FFTWMemory<T>::release(output);
+    FFTWMemory<T>::release(window);
+    FFTWMemory<T>::release(power);
+    input = output = window = power = nullptr;
+}
+
+static void executeR2HC(void *plan, double *in, double *out) {
+    fftw_execute_r2r((fftw_plan)plan, in, out);
+}
 
-    return samples;
+static void executeR2HC(void *plan, float *in, float *out) {
+    fftwf_execute_r2r((fftwf_plan)plan, in, out);
 }
 
-void DSPThread::applyHannWindow(QVector<double> &samples) {
-    int n = samples.size();
-    for (int i = 0; i < n; i++) {
-        double window = 0.5 * (1.0 - cos(2.0 * M_PI * i / (n - 1)));
-        samples[i] *= window;
+void DSPThread::accumulateFrame(const uint16_t *raw) {
+    m_frameStartNs = monotonicNs();
+    if (m_singlePrecision) {
+        transformFrame(raw, m_float);
+    } else {
+        transformFrame(raw, m_double);
+    }
+    m_framesInGroup++;
+    m_framesComputed++;
+}
+
+template <typename T>
+void DSPThread::transformFrame(const uint16_t *raw, FFTBuffers<T> &buffers) {
+    // Convert, remove DC and window straight into the FFT input
+    convertWindowFrame(raw, buffers.window, buffers.input, m_fftSize, &m_lastFrameStats);
+    m_frameConvertedNs = monotonicNs();
+    Profiler::record(Profiler::Convert, m_frameConvertedNs - m_frameStartNs);
+
+    {
+        ProfileTimer timer(Profiler::FFT);
+        executeR2HC(m_fftPlan, buffers.input, buffers.output);
+    }
+
+    // Only power per bin here - no sqrt/log10 and no allocation, so the
+    // per-frame cost stays at one FFT plus one pass over N/2 bins however
+    // high the overlap goes
+    PowerMode mode = PowerReplace;
+    if (m_framesInGroup > 0) {
+        mode = m_config.detector == DSPConfig::PeakHold ? PowerMax : PowerSum;
     }
+    ProfileTimer timer(Profiler::Power);
+    accumulatePower(buffers.output, m_fftSize, buffers.power, mode);
 }
 
-void DSPThread::computeFFT(const QVector<double> &samples,
-                           QVector<double> &magnitudes) {
-    // Copy samples to FFT input buffer
-    for (int i = 0; i < FFT_SIZE; i++) {
-        m_fftInput[i] = samples[i];
+void DSPThread::publishSpectrum() {
+    SpectrumFrameRef frame = m_framePool.acquire(m_fftSize / 2);
+    if (!frame) {
+        // Out of memory for the magnitudes: drop this spectrum, leaving a
+        // gap in the sequence, and start the next group
+        qWarning() << "No memory for a" << m_fftSize / 2 << "bin spectrum, dropped";
+        m_sequence++;
+        m_framesInGroup = 0;
+        return;
+    }
+    frame->axis = m_framePool.axis(m_sampleRate, m_fftSize);
+    frame->sequence = m_sequence++;
+
+    // Back-date the newest block's capture to the frame's last sample
+    SpectrumTimes &times = frame->times;
+    times = SpectrumTimes();
+    if (m_frameStartNs) {
+        uint64_t samplesAfter = m_history.written() - qMin(m_history.written(), m_lastFrameEnd);
+        times.captureNs = m_lastBlockNs - samplesAfter * 1000000000ULL / m_sampleRate;
+        times.startNs = m_frameStartNs;
+        times.convertedNs = m_frameConvertedNs;
     }
 
-    // Execute FFT
-    fftw_execute((fftw_plan)m_fftPlan);
+    {
+        ProfileTimer timer(Profiler::Db);
+        if (m_singlePrecision) {
+            fillSpectrum(m_float.power, *frame);
+        } else {
+            fillSpectrum(m_double.power, *frame);
+        }
+    }
 
-    // Compute magnitudes (convert to dB)
-    magnitudes.clear();
+    m_framesInGroup = 0;
+    m_spectraPublished++;
 
+    if (m_frameStartNs) {
+        times.publishedNs = monotonicNs();
+    }
+    ProfileTimer timer(Profiler::Publish);
+    m_bus.publish(frame);
+}
+
+template <typename T>
+void DSPThread::fillSpectrum(const T *power, SpectrumData &frame) {
     // Normalization factors:
-    // - FFT_SIZE: FFTW r2r doesn't normalize
+    // - m_fftSize: FFTW r2r doesn't normalize
     // - 2.0: Convert single-sided spectrum to power
-    // - Hann window coherent gain: 0.5
+    // - window coherent gain (0.5 for Hann), so tone amplitudes read the
+    //   same whichever window is selected
     // Reference: Full-scale sine wave (0.9V p-p = 0.45V amplitude)
     const double FULL_SCALE_VOLTAGE = 0.9;  // Adjust based on your signal levels
-    const double WINDOW_GAIN = 0.5;  // Hann window coherent gain
-    const double NORMALIZATION = FFT_SIZE * WINDOW_GAIN;
+    const double NORMALIZATION = m_fftSize * m_windowTable->coherentGain();
+    frame.enbw = m_windowTable->enbw();
+
+    // Welch: mean power over the group; peak hold is already a single frame
+    const double groupScale = (m_config.detector == DSPConfig::Average && m_framesInGroup > 0)
+                              ? 1.0 / m_framesInGroup : 1.0;
+    const int half = m_fftSize / 2;
+
+    // dBFS = 20*log10(2 * |X| / NORMALIZATION / FULL_SCALE_VOLTAGE)
+    //      = 10*log10(|X|^2 * binScale), so no sqrt and one multiply per bin
+    const double binScale = groupScale * 4.0
+                            / (NORMALIZATION * NORMALIZATION * FULL_SCALE_VOLTAGE * FULL_SCALE_VOLTAGE);
 
     // DC component (skip it - usually just noise)
-    // magnitudes.append(-80.0);
+    double *db = frame.magnitudes;
+    powerToDb(power + 1, db, half - 1, binScale, -80.0f);
 
-    // Other bins (half-complex format)
-    for (int i = 1; i < FFT_SIZE / 2; i++) {
-        double real = m_fftOutput[i];
-        double imag = m_fftOutput[FFT_SIZE - i];
-        double mag = sqrt(real * real + imag * imag);
+    // Nyquist is not doubled - it has no mirror image
+    powerToDb(power + half, db + half - 1, 1, binScale / 4.0, -80.0f);
+}
+
+void DSPThread::reportStats() {
+    uint64_t now = monotonicNs();
+    double seconds = (now - m_statsStartNs) / 1e9;
+    if (seconds <= 0.0) {
+        return;
+    }
 
-        // Normalize and convert to voltage amplitude
-        double voltage_amplitude = (mag / NORMALIZATION) * 2.0;
+    // Share of the stream that lands in at least one frame: hops longer
+    // than the frame leave gaps, falling behind skips samples outright
+    uint64_t written = m_history.written() - m_statsWritten;
+    uint64_t skipped = m_samplesSkipped - m_statsSkipped;
+    m_statsWritten = m_history.written();
+    m_statsSkipped = m_samplesSkipped;
 
-        // Convert to dB relative to full scale
-        // dBFS = 20 * log10(amplitude / reference)
-        double db = 20.0 * log10(voltage_amplitude / FULL_SCALE_VOLTAGE + 1e-10);
-        magnitudes.append(qMax(db, -80.0));
+    double coverage = qMin(1.0, m_fftSize / (double)m_hopSize);
+    if (written > 0) {
+        coverage *= 1.0 - qMin(1.0, skipped / (double)written);
     }
 
-    // Nyquist component
-    double mag_nyq = fabs(m_fftOutput[FFT_SIZE / 2]);
-    double voltage_amplitude_nyq = (mag_nyq / NORMALIZATION);
-    double db_nyq = 20.0 * log10(voltage_amplitude_nyq / FULL_SCALE_VOLTAGE + 1e-10);
-    magnitudes.append(qMax(db_nyq, -80.0));
+    // 100% probability of intercept: wherever an event this long starts,
+    // at least one frame lies entirely inside it, as long as nothing is
+    // skipped
+    double poiMs = (m_fftSize + m_hopSize - 1) * 1000.0 / m_sampleRate;
+
+    // Stage timings are in the Profiler; this is the stream's health
+    const FrameStats &adc = m_lastFrameStats;
+    QDebug line = qDebug();
+    line << "DSP -" << (m_framesComputed / seconds) << "frames/s"
+         << (m_spectraPublished / seconds) << "spectra/s"
+         << "| Load:" << (100.0 * m_busyNs / (now - m_statsStartNs)) << "%"
+         << "| Coverage:" << (100.0 * coverage) << "%";
+    if (coverage >= 1.0) {
+        line << "| 100% POI for events >=" << poiMs << "ms";
+    } else {
+        line << "| POI < 100%";
+    }
+    line << "| ADC min/avg/max:" << (adc.minRaw * ADC_VOLTS_PER_CODE)
+         << (adc.meanRaw * ADC_VOLTS_PER_CODE) << (adc.maxRaw * ADC_VOLTS_PER_CODE) << "V"
+         << "| Skipped:" << m_samplesSkipped << "samples |" << m_source->statusText();
+
+    // Per subscriber, since start: what its drop policy threw away
+    for (const SpectrumSubscriptionPtr &subscription : m_bus.subscriptions()) {
+        line << "|" << subscription->name().c_str() << "dropped"
+             << subscription->dropped() << "/" << subscription->offered();
+    }
+
+    m_framesComputed = 0;
+    m_spectraPublished = 0;
+    m_busyNs = 0;
+    m_statsStartNs = now;
 }
 
 void DSPThread::run() {
     m_running = true;
+    Profiler::registerThread("dsp");
 
-    // Try to map PRU memory
-    mapPRUMemory();
-    if (m_pruBuffer) {
-        qDebug() << "Successfully mapped shared memory - using real ADC data";
-    } else {
-        qDebug() << "Could not map shared memory - using test signal";
+    if (!openSampleSource()) {
+        if (m_source) {
+            qDebug() << "Could not open sample source" << m_source->description();
+        }
+        m_sourceFailed = true;
+        m_bus.close();
+        return;
     }
+    m_sampleRate = m_source->sampleRate();
+    qDebug() << "Sampling from" << m_source->description()
+             << "| FFT planner:" << FFTPlanCache::effortName(m_planCache->effort())
+             << (m_singlePrecision ? "float32" : "float64");
+
+    // The startup size is planned here, before samples start queueing;
+    // with wisdom on disk this is as quick as FFTW_ESTIMATE
+    m_history.reset(0);
+    int size = m_requestedFFTSize;
+    applyFFTSize(size, m_planCache->planNow(size));
+    m_samplesSkipped = 0;
+    m_statsWritten = 0;
+    m_statsSkipped = 0;
+    m_lastDroppedBlocks = m_source->droppedBlocks();
+    m_statsStartNs = monotonicNs();
 
     while (m_running) {
-        // Read samples
-        QVector<double> samples = readPRUSamples(FFT_SIZE);
-
-        // Apply window
-        applyHannWindow(samples);
-
-        // Compute FFT
-        SpectrumData data;
-        data.sampleRate = SAMPLE_RATE;
-        data.fftSize = FFT_SIZE;
-        data.numBins = FFT_SIZE / 2 + 1;
-
-        computeFFT(samples, data.magnitudes);
+        // Size switch: the plan cache measures new sizes on its worker,
+        // we keep going at the old size until the plan is ready
+        int requested = m_requestedFFTSize;
+        if (requested != m_fftSize) {
+            void *plan = m_planCache->plan(requested);
+            if (plan) {
+                applyFFTSize(requested, plan);
+            }
+        }
+        if (m_windowChanged) {
+            applyWindow();
+        }
 
-        // Generate frequency bins
-        for (int i = 1; i < data.numBins; i++) {
-            double freq = i * SAMPLE_RATE / (double)FFT_SIZE;
-            data.frequencies.append(freq);
+        // Process every frame the history can supply before waiting for
+        // more data, so bursts after a stall are caught up back to back
+        uint64_t busyStart = monotonicNs();
+        const uint16_t *raw = nextFrame();
+        if (raw) {
+            accumulateFrame(raw);
+            if (m_framesInGroup >= m_averages) {
+                publishSpectrum();
+            }
+            m_busyNs += monotonicNs() - busyStart;
+            continue;
         }
 
-        // Emit data
-        emit spectrumReady(data);
+        if (acquireBlock()) {
+            if (monotonicNs() - m_statsStartNs >= STATS_INTERVAL_NS) {
+                reportStats();
+            }
+            continue;
+        }
+        if (m_source->atEnd()) {
+            break;
+        }
 
-        // No fixed delay - pace based on PRU buffer rate
-        // At 48 kHz, buffers arrive every ~21ms naturally
-        // This gives ~47 Hz update rate (smooth and responsive)
+        // Stalled source: show silence rather than a frozen trace
+        for (int i = 0; i <= m_fftSize / 2; i++) {
+            if (m_singlePrecision) {
+                m_float.power[i] = 0.0f;
+            } else {
+                m_double.power[i] = 0.0;
+            }
+        }
+        m_framesInGroup = 1;
+        m_frameStartNs = 0;   // nothing captured to trace
+        publishSpectrum();
     }
+
+    m_source->close();
+    m_bus.close();
 }
 
 void DSPThread::stop() {
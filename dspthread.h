@@ -4,49 +4,163 @@
 #include <QThread>
 #include <atomic>
 #include "spectrumdata.h"
+#include "samplesource.h"
+#include "samplehistory.h"
+#include "dspkernels.h"
+#include "fftplancache.h"
+#include "windowtable.h"
+#include "spectrumbus.h"
+#include <QMutex>
+
+// Processing settings (command line, see main.cpp)
+struct DSPConfig {
+    // How the frames of one averaging group are combined
+    enum Detector {
+        Average,   // Welch: mean power
+        PeakHold   // max power per bin, keeps short transients visible
+    };
+
+    QString sourceSpec;   // SampleSource::create() spec; empty = PRU, test tone fallback
+    bool testToneFallback;   // false: a bad spec or missing PRU stops the thread
+    int fftSize;          // 256 .. 65536 samples
+    int hopSize;          // samples between frame starts; 0 = from overlap
+    double overlap;       // fraction of a frame shared with the next (0, .5, .75, .875)
+    int averages;         // frames per displayed spectrum; 0 = auto (~MAX_SPECTRA_RATE)
+    Detector detector;
+    FFTPlanCache::Precision precision;   // window, FFT input/output and power
+    FFTPlanCache::Effort planEffort;
+    QString wisdomPath;   // FFTW wisdom file; empty = don't persist
+    WindowTable::Type window;
+    double windowParameter;   // Kaiser beta
+
+    DSPConfig() : testToneFallback(true), fftSize(1024), hopSize(0), overlap(0.0), averages(0), detector(Average),
+                  precision(FFTPlanCache::Double), planEffort(FFTPlanCache::Measure),
+                  window(WindowTable::Hann), windowParameter(0.0) {}
+};
+
+// fftw_malloc'd per-frame working set in one precision
+template <typename T>
+struct FFTBuffers {
+    T* input;
+    T* output;
+    T* window;   // WindowTable coefficients pre-scaled by ADC_VOLTS_PER_CODE
+    T* power;    // |X|^2 per bin, summed or max-held over the group
+
+    FFTBuffers() : input(nullptr), output(nullptr), window(nullptr), power(nullptr) {}
+    void allocate(int n);
+    void release();
+    void loadWindow(const WindowTable &table);
+};
 
 class DSPThread : public QThread {
     Q_OBJECT
 
 public:
-    DSPThread(QObject *parent = nullptr);
+    explicit DSPThread(const DSPConfig &config = DSPConfig(), QObject *parent = nullptr);
     ~DSPThread();
 
     void stop();
 
-    signals:
-            void spectrumReady(const SpectrumData &data);
+    // Takes ownership and overrides config.sourceSpec. Call before start().
+    void setSampleSource(SampleSource *source);
+
+    // Thread safe. Takes effect at the next frame once a plan for the new
+    // size exists; until then processing carries on at the old size.
+    void setFFTSize(int n);
+    int fftSize() const { return m_requestedFFTSize; }
+
+    // Thread safe, applied at the next frame. Restarts the averaging group.
+    void setWindow(WindowTable::Type type, double parameter = 0.0);
+
+    static const int MIN_FFT_SIZE = 256;
+    static const int MAX_FFT_SIZE = 65536;
+
+    // Auto averaging keeps published spectra at or below this rate; the
+    // UI only refreshes at ~30 Hz anyway
+    static const int MAX_SPECTRA_RATE = 50;
+
+    // Every published spectrum goes out here; subscribe from any thread,
+    // before or after start(). Closed when the thread finishes.
+    SpectrumBus& bus() { return m_bus; }
+
+    // No source could be opened, so run() closed the bus without
+    // publishing anything. Read it once the bus is closed.
+    bool sourceFailed() const { return m_sourceFailed; }
 
 protected:
     void run() override;
 
 private:
-    // PRU interface
-    void* mapPRUMemory();
-    void unmapPRUMemory();
-    QVector<double> readPRUSamples(int numSamples);
+    // Sample acquisition: source blocks are stitched into m_history and
+    // frames of m_fftSize are cut from it every m_hopSize samples
+    bool openSampleSource();
+    bool acquireBlock();
+    const uint16_t* nextFrame();
 
-    uint16_t* m_pruBuffer;
-    int m_pruMemFd;
+    SampleSource* m_source;
+    int m_sampleRate;
+    SampleHistory m_history;
+    uint64_t m_nextFrameStart;
+    uint64_t m_lastDroppedBlocks;
+    uint64_t m_samplesSkipped;
+    int m_stuckCount;          // empty acquires in a row, for the stall warning
+    uint64_t m_statsWritten;   // history written() and m_samplesSkipped at
+    uint64_t m_statsSkipped;   // the last reportStats(), for coverage
+    FrameStats m_lastFrameStats;
 
-    // FFT processing
-    void initFFT();
+    // FFT processing: every frame is transformed and folded into
+    // the power buffer; dB conversion and publish happen once per group
+    void applyFFTSize(int n, void *plan);
+    void applyWindow();
     void cleanupFFT();
-    void computeFFT(const QVector<double> &samples,
-                    QVector<double> &magnitudes);
-    void applyHannWindow(QVector<double> &samples);
+    void accumulateFrame(const uint16_t *raw);
+    template <typename T> void transformFrame(const uint16_t *raw, FFTBuffers<T> &buffers);
+    void publishSpectrum();
+    template <typename T> void fillSpectrum(const T *power, SpectrumData &frame);
+    // The stream's rates, coverage, ADC levels and drops, to the log; stage
+    // timings are the Profiler's
+    void reportStats();
+    static const uint64_t STATS_INTERVAL_NS = 10000000000ULL;
 
     // State
     std::atomic<bool> m_running;
+    std::atomic<bool> m_sourceFailed;
 
-    // FFT objects (FFTW)
+    // FFT objects (FFTW); plans belong to m_planCache
+    FFTPlanCache* m_planCache;
+    std::atomic<int> m_requestedFFTSize;
     void* m_fftPlan;
-    double* m_fftInput;
-    double* m_fftOutput;
+    bool m_singlePrecision;
+    QSharedPointer<const WindowTable> m_windowTable;
+    QMutex m_windowMutex;   // m_config.window, m_config.windowParameter
+    std::atomic<bool> m_windowChanged;
+    FFTBuffers<double> m_double;   // only the one in use is allocated
+    FFTBuffers<float> m_float;
+    int m_framesInGroup;
+
+    // Throughput, reset by reportStats()
+    uint64_t m_framesComputed;
+    uint64_t m_spectraPublished;
+
+    uint64_t m_busyNs;
+    uint64_t m_statsStartNs;
+
+    // Spectra: pooled frames broadcast by reference to the bus
+    // subscribers, so nothing is copied or allocated per spectrum. The
+    // pool is declared first so it outlives the bus's references.
+    SpectrumFramePool m_framePool;
+    SpectrumBus m_bus;
+    uint64_t m_sequence;
+    uint64_t m_lastBlockNs;      // when the newest block's last sample was captured
+    uint64_t m_frameStartNs;     // last frame's processing began; 0: not from samples
+    uint64_t m_frameConvertedNs; // ... and its input was ready for the FFT
+    uint64_t m_lastFrameEnd;     // history position just past the last frame
 
-    // Constants
-    static const int FFT_SIZE = 1024;
-    static const int SAMPLE_RATE = 48000;
+    // Frame geometry
+    DSPConfig m_config;
+    int m_fftSize;
+    int m_hopSize;
+    int m_averages;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "fftplancache.h"
+#include <fftw3.h>
+#include <QFile>
+#include <QDebug>
+#include <ctime>
+
+std::mutex FFTPlanCache::s_plannerMutex;
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+FFTPlanCache::FFTPlanCache(Precision precision, Effort effort, const QString &wisdomPath)
+        : m_precision(precision)
+        , m_effort(effort)
+        , m_stopping(false)
+{
+    // fftw and fftwf keep separate wisdom in incompatible files
+    if (effort != Estimate && !wisdomPath.isEmpty()) {
+        m_wisdomPath = precision == Float ? wisdomPath + ".f32" : wisdomPath;
+    }
+
+    if (!m_wisdomPath.isEmpty()) {
+        std::lock_guard<std::mutex> planner(s_plannerMutex);
+        QByteArray path = m_wisdomPath.toLocal8Bit();
+        if (!QFile::exists(m_wisdomPath)) {
+            qDebug() << "No FFTW wisdom at" << m_wisdomPath << "- plans will be measured";
+        } else if (m_precision == Float ? fftwf_import_wisdom_from_filename(path.constData())
+                                        : fftw_import_wisdom_from_filename(path.constData())) {
+            qDebug() << "Loaded FFTW wisdom from" << m_wisdomPath;
+        } else {
+            qWarning() << "Could not read FFTW wisdom from" << m_wisdomPath;
+        }
+    }
+
+    m_worker = std::thread(&FFTPlanCache::workerLoop, this);
+}
+
+FFTPlanCache::~FFTPlanCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+
+    std::lock_guard<std::mutex> planner(s_plannerMutex);
+    for (void *p : m_plans) {
+        if (m_precision == Float) {
+            fftwf_destroy_plan((fftwf_plan)p);
+        } else {
+            fftw_destroy_plan((fftw_plan)p);
+        }
+    }
+    m_plans.clear();
+}
+
+QString FFTPlanCache::effortName(Effort effort) {
+    switch (effort) {
+    case Estimate: return "estimate";
+    case Measure:  return "measure";
+    case Patient:  return "patient";
+    }
+    return QString();
+}
+
+void* FFTPlanCache::plan(int n) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    void *p = m_plans.value(n, nullptr);
+    if (!p && !m_queue.contains(n)) {
+        m_queue.append(n);
+        m_wake.notify_one();
+    }
+    return p;
+}
+
+void* FFTPlanCache::planNow(int n) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        void *p = m_plans.value(n, nullptr);
+        if (p) {
+            return p;
+        }
+    }
+
+    std::lock_guard<std::mutex> planner(s_plannerMutex);
+
+    // The worker may have finished this size while we waited
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        void *p = m_plans.value(n, nullptr);
+        if (p) {
+            return p;
+        }
+    }
+
+    void *p = createPlan(n);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_plans.insert(n, p);
+    return p;
+}
+
+void* FFTPlanCache::createPlan(int n) {
+    unsigned flags = FFTW_ESTIMATE;
+    if (m_effort == Measure) {
+        flags = FFTW_MEASURE;
+    } else if (m_effort == Patient) {
+        flags = FFTW_PATIENT;
+    }
+
+    // Already in the loaded wisdom: as fast as estimate, no save needed
+    bool fromWisdom = false;
+    void *p = nullptr;
+    uint64_t start = monotonicNs();
+
+    // MEASURE/PATIENT scribble over the arrays, so plan on scratch buffers
+    if (m_precision == Float) {
+        float *in = (float*)fftwf_malloc(sizeof(float) * n);
+        float *out = (float*)fftwf_malloc(sizeof(float) * n);
+        if (m_effort != Estimate) {
+            p = fftwf_plan_r2r_1d(n, in, out, FFTW_R2HC, flags | FFTW_WISDOM_ONLY);
+            fromWisdom = (p != nullptr);
+        }
+        start = monotonicNs();
+        if (!p) {
+            p = fftwf_plan_r2r_1d(n, in, out, FFTW_R2HC, flags);
+        }
+        fftwf_free(in);
+        fftwf_free(out);
+    } else {
+        double *in = (double*)fftw_malloc(sizeof(double) * n);
+        double *out = (double*)fftw_malloc(sizeof(double) * n);
+        if (m_effort != Estimate) {
+            p = fftw_plan_r2r_1d(n, in, out, FFTW_R2HC, flags | FFTW_WISDOM_ONLY);
+            fromWisdom = (p != nullptr);
+        }
+        start = monotonicNs();
+        if (!p) {
+            p = fftw_plan_r2r_1d(n, in, out, FFTW_R2HC, flags);
+        }
+        fftw_free(in);
+        fftw_free(out);
+    }
+
+    if (m_effort != Estimate) {
+        if (fromWisdom) {
+            qDebug() << "FFT plan" << n << "from wisdom";
+        } else {
+            qDebug() << "FFT plan" << n << effortName(m_effort) << "took"
+                     << (monotonicNs() - start) / 1000000 << "ms";
+            saveWisdom();
+        }
+    }
+    return p;
+}
+
+void FFTPlanCache::saveWisdom() {
+    if (m_wisdomPath.isEmpty()) {
+        return;
+    }
+    // Write next to the target and rename, so a crash mid-write can't
+    // leave a truncated file that fails to load on the next boot
+    QString tmp = m_wisdomPath + ".tmp";
+    QByteArray path = tmp.toLocal8Bit();
+    if (!(m_precision == Float ? fftwf_export_wisdom_to_filename(path.constData())
+                               : fftw_export_wisdom_to_filename(path.constData()))) {
+        qWarning() << "Could not write FFTW wisdom to" << tmp;
+        return;
+    }
+    QFile::remove(m_wisdomPath);
+    if (!QFile::rename(tmp, m_wisdomPath)) {
+        qWarning() << "Could not write FFTW wisdom to" << m_wisdomPath;
+    }
+}
+
+void FFTPlanCache::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_stopping || !m_queue.isEmpty(); });
+        if (m_stopping) {
+            return;
+        }
+        int n = m_queue.first();
+        lock.unlock();
+
+        void *p;
+        {
+            std::lock_guard<std::mutex> planner(s_plannerMutex);
+            lock.lock();
+            p = m_plans.value(n, nullptr);
+            lock.unlock();
+            if (!p) {
+                p = createPlan(n);
+            }
+        }
+
+        lock.lock();
+        m_plans.insert(n, p);
+        m_queue.removeAll(n);
+    }
+}
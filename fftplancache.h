@@ -0,0 +1,71 @@
+#ifndef FFTPLANCACHE_H
+#define FFTPLANCACHE_H
+
+#include <QString>
+#include <QMap>
+#include <QVector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Real-to-halfcomplex FFTW plans, one per size, shared for the life of the
+// cache. Plans are executed with fftw_execute_r2r() (fftwf_execute_r2r()
+// for Float) on the caller's own fftw_malloc'd (fftwf_malloc'd) buffers,
+// so one plan serves any frame of that size.
+//
+// The FFTW planner is process-wide and not thread safe, so every cache
+// plans under one lock, and FFTW_MEASURE/PATIENT can take seconds on the
+// BeagleBone, so sizes requested through plan() are planned on a worker
+// thread while the caller keeps running with what it has. Wisdom is loaded from wisdomPath at startup and written back
+// after every new measured plan, so only the first boot pays for it.
+class FFTPlanCache {
+public:
+    enum Precision {
+        Double,     // fftw_plan
+        Float       // fftwf_plan, wisdom in <wisdomPath>.f32
+    };
+
+    enum Effort {
+        Estimate,   // heuristic, instant, no wisdom
+        Measure,
+        Patient
+    };
+
+    // Empty wisdomPath: don't load or save wisdom
+    FFTPlanCache(Precision precision, Effort effort, const QString &wisdomPath);
+    ~FFTPlanCache();
+
+    // Plan for n points, or nullptr if it isn't ready yet, in which case
+    // it is queued for the worker. Never blocks on the planner.
+    void* plan(int n);
+
+    // Plan for n points, planning on the calling thread if needed
+    void* planNow(int n);
+
+    Precision precision() const { return m_precision; }
+    Effort effort() const { return m_effort; }
+    static QString effortName(Effort effort);
+
+private:
+    void* createPlan(int n);   // call with s_plannerMutex held
+    void saveWisdom();         // call with s_plannerMutex held
+    void workerLoop();
+
+    Precision m_precision;
+    Effort m_effort;
+    QString m_wisdomPath;
+
+    // FFTW planner calls, plan creation/destruction and wisdom I/O. The
+    // planner and wisdom are process-wide, so one lock for every cache.
+    static std::mutex s_plannerMutex;
+
+    // m_plans, m_queue, m_stopping
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    QMap<int, void*> m_plans;
+    QVector<int> m_queue;
+    bool m_stopping;
+    std::thread m_worker;
+};
+
+#endif
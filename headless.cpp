@@ -0,0 +1,72 @@
+#include "headless.h"
+#include <QDebug>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+
+static std::atomic<bool> s_stopRequested(false);
+
+static void requestStop(int) {
+    s_stopRequested.store(true, std::memory_order_relaxed);
+}
+
+static void installSignalHandlers() {
+    // The first SIGINT / SIGTERM ends the run cleanly; SA_RESETHAND puts
+    // the default action back, so a second one still kills a run stuck
+    // on a stalled reader
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // A reader that goes away is a write error, not a silent exit
+    signal(SIGPIPE, SIG_IGN);
+}
+
+int runHeadless(const DSPConfig &config, const HeadlessConfig &headless) {
+    SpectrumWriter writer(headless.format);
+    if (!writer.open(headless.output.toStdString())) {
+        qWarning() << "Cannot open output" << QString::fromStdString(writer.error());
+        return 1;
+    }
+    installSignalHandlers();
+
+    // Gap free up to about a second of spectra behind; the DSP thread
+    // never waits on us, so a slow reader only costs its own spectra
+    DSPThread dsp(config);
+    SpectrumSubscriptionPtr spectra =
+            dsp.bus().subscribe("writer", SpectrumSubscription::Blocking, 64);
+    dsp.start();
+
+    int status = 0;
+    while (!s_stopRequested.load(std::memory_order_relaxed)) {
+        // Closed and then found empty: everything has been written
+        bool closed = spectra->closed();
+        SpectrumFrameRef frame = spectra->wait(200);
+        if (!frame) {
+            if (closed) {
+                break;
+            }
+            continue;
+        }
+        if (!writer.write(*frame)) {
+            qWarning() << "Writing spectra failed:" << QString::fromStdString(writer.error());
+            status = 1;
+            break;
+        }
+        if (headless.spectra && writer.spectraWritten() >= headless.spectra) {
+            break;
+        }
+    }
+
+    dsp.stop();
+    if (dsp.sourceFailed()) {
+        status = 1;
+    }
+    qDebug() << "Wrote" << writer.spectraWritten() << "spectra," << writer.bytesWritten()
+             << "bytes to" << headless.output << "|" << spectra->dropped() << "dropped";
+    return status;
+}
@@ -0,0 +1,26 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QString>
+#include "dspthread.h"
+#include "spectrumwriter.h"
+
+// Headless settings (command line, see main.cpp)
+struct HeadlessConfig {
+    QString output;                  // "-" (stdout), a file or a named pipe
+    SpectrumWriter::Format format;
+    uint64_t spectra;                // stop after this many; 0: until the source ends
+
+    HeadlessConfig() : output("-"), format(SpectrumWriter::Float32), spectra(0) {}
+};
+
+// Runs the DSP pipeline without a display: every spectrum DSPThread
+// publishes is written with SpectrumWriter, on the calling thread, until
+// the source ends, `spectra` are written, the output fails (reader gone)
+// or SIGINT / SIGTERM; a second signal kills outright. Needs only a
+// QCoreApplication, and no event loop. Returns the exit status; it is 1
+// when no source opened, which with config.testToneFallback off (as
+// main.cpp sets it) includes a node without a PRU.
+int runHeadless(const DSPConfig &config, const HeadlessConfig &headless);
+
+#endif
@@ -0,0 +1,184 @@
+#include "latencystats.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void LatencyHistogram::clear() {
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sumNs = 0;
+    m_maxNs = 0;
+}
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < 1024) {
+        return 0;
+    }
+    // Octave of ns (10 = 1 us), then the next 3 bits below the top one
+    int octave = 63 - __builtin_clzll(ns);
+    if (octave >= 34) {
+        return BUCKETS - 1;
+    }
+    int sub = (int)((ns >> (octave - 3)) & 7);
+    return 1 + (octave - 10) * 8 + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperNs(int bucket) {
+    if (bucket <= 0) {
+        return 1024;
+    }
+    if (bucket >= BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    int octave = 10 + (bucket - 1) / 8;
+    int sub = (bucket - 1) % 8;
+    return (uint64_t)(8 + sub + 1) << (octave - 3);
+}
+
+void LatencyHistogram::add(uint64_t ns) {
+    m_buckets[bucketOf(ns)]++;
+    m_count++;
+    m_sumNs += ns;
+    m_maxNs = std::max(m_maxNs, ns);
+}
+
+void LatencyHistogram::addBuckets(const uint64_t *counts, uint64_t sumNs, uint64_t maxNs) {
+    for (int i = 0; i < BUCKETS; i++) {
+        m_buckets[i] += counts[i];
+        m_count += counts[i];
+    }
+    m_sumNs += sumNs;
+    m_maxNs = std::max(m_maxNs, maxNs);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (int i = 0; i < BUCKETS; i++) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_sumNs += other.m_sumNs;
+    m_maxNs = std::max(m_maxNs, other.m_maxNs);
+}
+
+uint64_t LatencyHistogram::percentileNs(double p) const {
+    if (m_count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * (m_count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            // The top bucket's edge can overstate the largest sample
+            return std::min(bucketUpperNs(i), m_maxNs);
+        }
+    }
+    return m_maxNs;
+}
+
+const char* LatencyStats::stageName(int stage) {
+    static const char *names[NUM_STAGES] = { "wait", "convert", "fft", "handoff", "render", "total" };
+    return stage >= 0 && stage < NUM_STAGES ? names[stage] : "?";
+}
+
+uint64_t LatencyStats::nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Clocks are read on different threads; a step that comes out negative
+// (within clock_gettime's granularity) counts as zero
+static uint64_t span(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+
+void LatencyStats::record(const SpectrumTimes &times, uint64_t pickupNs, uint64_t displayedNs) {
+    if (times.captureNs == 0) {
+        return;
+    }
+    m_stages[Wait].add(span(times.captureNs, times.startNs));
+    m_stages[Convert].add(span(times.startNs, times.convertedNs));
+    m_stages[FFT].add(span(times.convertedNs, times.publishedNs));
+    m_stages[Handoff].add(span(times.publishedNs, pickupNs));
+    m_stages[Render].add(span(pickupNs, displayedNs));
+    m_stages[Total].add(span(times.captureNs, displayedNs));
+}
+
+void LatencyStats::merge(const LatencyStats &other) {
+    for (int s = 0; s < NUM_STAGES; s++) {
+        m_stages[s].merge(other.m_stages[s]);
+    }
+}
+
+void LatencyStats::clear() {
+    for (int s = 0; s < NUM_STAGES; s++) {
+        m_stages[s].clear();
+    }
+}
+
+std::string LatencyStats::summary() const {
+    std::string text;
+    char line[96];
+    snprintf(line, sizeof(line), "%-8s %8s %8s %8s  (ms, %llu spectra)", "",
+             "p50", "p99", "max", (unsigned long long)count());
+    text += line;
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const LatencyHistogram &h = m_stages[s];
+        snprintf(line, sizeof(line), "\n%-8s %8.2f %8.2f %8.2f", stageName(s),
+                 h.percentileNs(0.5) / 1e6, h.percentileNs(0.99) / 1e6, h.maxNs() / 1e6);
+        text += line;
+    }
+    return text;
+}
+
+bool LatencyStats::dump(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "# Spectrum latency, capture to screen, %llu spectra\n",
+            (unsigned long long)count());
+    fprintf(file, "# stage      p50_us      p90_us      p99_us      max_us     mean_us\n");
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const LatencyHistogram &h = m_stages[s];
+        fprintf(file, "%-8s %11.1f %11.1f %11.1f %11.1f %11.1f\n", stageName(s),
+                h.percentileNs(0.5) / 1e3, h.percentileNs(0.9) / 1e3, h.percentileNs(0.99) / 1e3,
+                h.maxNs() / 1e3, h.meanNs() / 1e3);
+    }
+
+    // Non-empty buckets: upper edge, then the count per stage
+    fprintf(file, "\n# upper_us");
+    for (int s = 0; s < NUM_STAGES; s++) {
+        fprintf(file, " %s", stageName(s));
+    }
+    fprintf(file, "\n");
+    for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+        bool any = false;
+        for (int s = 0; s < NUM_STAGES; s++) {
+            any |= m_stages[s].bucketCount(i) != 0;
+        }
+        if (!any) {
+            continue;
+        }
+        uint64_t upper = LatencyHistogram::bucketUpperNs(i);
+        if (upper == UINT64_MAX) {
+            fprintf(file, "inf");
+        } else {
+            fprintf(file, "%.3f", upper / 1e3);
+        }
+        for (int s = 0; s < NUM_STAGES; s++) {
+            fprintf(file, " %llu", (unsigned long long)m_stages[s].bucketCount(i));
+        }
+        fprintf(file, "\n");
+    }
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
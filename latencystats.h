@@ -0,0 +1,79 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <cstdint>
+#include <string>
+#include "spectrumdata.h"
+
+// Log-scale histogram of durations: one bucket below 1 us, then 8 per
+// octave (12.5% wide) up to ~17 s, and one overflow bucket. Fixed size, so
+// adding a sample is a few instructions and never allocates.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(uint64_t ns);
+    void merge(const LatencyHistogram &other);
+    void clear();
+
+    uint64_t count() const { return m_count; }
+    uint64_t maxNs() const { return m_maxNs; }
+    double meanNs() const { return m_count ? (double)m_sumNs / m_count : 0.0; }
+    // Upper edge of the bucket holding the p quantile (0..1)
+    uint64_t percentileNs(double p) const;
+
+    static const int BUCKETS = 1 + 24 * 8 + 1;
+    uint64_t bucketCount(int bucket) const { return m_buckets[bucket]; }
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketUpperNs(int bucket);
+
+    // For counts kept elsewhere in the same layout (Profiler)
+    void addBuckets(const uint64_t *counts, uint64_t sumNs, uint64_t maxNs);
+
+private:
+    uint64_t m_buckets[BUCKETS];
+    uint64_t m_count;
+    uint64_t m_sumNs;
+    uint64_t m_maxNs;
+};
+
+// Where the time goes between the ADC and the screen, per displayed
+// spectrum (see SpectrumTimes):
+//
+//   wait      newest sample captured -> DSPThread starts the frame (rest of
+//             the PRU slot, wakeup, frames queued ahead of it)
+//   convert   convert, DC removal and window
+//   fft       FFT, power, group average and dB
+//   handoff   on the bus -> a renderer starts on it (includes refresh cap)
+//   render    -> on screen: end of the blit (render thread) or of the
+//             QCustomPlot replot (GUI thread renderers)
+//   total     newest sample captured -> on screen
+//
+// Filled on the GUI thread only.
+class LatencyStats {
+public:
+    enum Stage { Wait, Convert, FFT, Handoff, Render, Total, NUM_STAGES };
+    static const char* stageName(int stage);
+
+    // CLOCK_MONOTONIC, the clock SpectrumTimes is in
+    static uint64_t nowNs();
+
+    // Spectra not from captured samples (captureNs 0) are skipped
+    void record(const SpectrumTimes &times, uint64_t pickupNs, uint64_t displayedNs);
+    void merge(const LatencyStats &other);
+    void clear();
+
+    const LatencyHistogram& stage(int stage) const { return m_stages[stage]; }
+    uint64_t count() const { return m_stages[Total].count(); }
+
+    // One line per stage: p50 / p99 / max in ms
+    std::string summary() const;
+    // Quantiles and the raw histograms, as text; false if the file can't
+    // be written
+    bool dump(const std::string &path) const;
+
+private:
+    LatencyHistogram m_stages[NUM_STAGES];
+};
+
+#endif
@@ -1,15 +1,219 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QScopedPointer>
+#include <cstring>
 #include "mainwindow.h"
+#include "headless.h"
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
+    // Headless runs have no display to connect to, so the application
+    // object is picked before the command line is parsed
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        headless |= strcmp(argv[i], "--headless") == 0;
+    }
+    QScopedPointer<QCoreApplication> app(headless ? new QCoreApplication(argc, argv)
+                                                  : new QApplication(argc, argv));
 
-    // register custom data type
-    qRegisterMetaType<SpectrumData>("SpectrumData");
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Audio spectrum analyzer");
+    parser.addHelpOption();
+    QCommandLineOption sourceOption("source",
+            "Sample source: pru[:uio=<dev>|poll], shm[:name], "
+            "file:<path>[,rate=,block=,loop=,realtime=], "
+            "gen[:tone=<hz>[:<vpk>][+...],noise=,pink=,dc=,step=,duration=,rate=,block=,realtime=,seed=] "
+            "or sim[:<gen options>]. "
+            "Default: pru, falling back to a 10 kHz test tone "
+            "(--headless exits with status 1 instead).",
+            "spec");
+    parser.addOption(sourceOption);
+    QCommandLineOption fftSizeOption("fft-size",
+            "FFT length in samples, 256-65536 (default 1024).", "n", "1024");
+    parser.addOption(fftSizeOption);
+    QCommandLineOption hopOption("hop",
+            "Samples between successive FFT frames. Overrides --overlap.", "n");
+    parser.addOption(hopOption);
+    QCommandLineOption overlapOption("overlap",
+            "Frame overlap in percent: 0, 50, 75 or 87.5 (default 0).", "percent", "0");
+    parser.addOption(overlapOption);
+    QCommandLineOption averagesOption("averages",
+            "Frames combined into each displayed spectrum "
+            "(default: auto, about 50 spectra/s).", "n", "0");
+    parser.addOption(averagesOption);
+    QCommandLineOption detectorOption("detector",
+            "How averaged frames combine: avg (Welch mean power, default) "
+            "or peak (max hold, keeps short transients).", "avg|peak", "avg");
+    parser.addOption(detectorOption);
+    QCommandLineOption plannerOption("fft-planner",
+            "FFTW planning effort: estimate, measure (default) or patient. "
+            "Measured plans are kept in the wisdom file.", "effort", "measure");
+    parser.addOption(plannerOption);
+    QCommandLineOption wisdomOption("wisdom",
+            "FFTW wisdom file, loaded at startup and updated after new plans "
+            "(default ~/.spectrum_analyzer.wisdom, empty to disable).", "path",
+            QDir::homePath() + "/.spectrum_analyzer.wisdom");
+    parser.addOption(wisdomOption);
+    QCommandLineOption precisionOption("precision",
+            "DSP arithmetic: double (default) or float. float halves memory "
+            "traffic and lets NEON vectorize; see dsp_bench accuracy.",
+            "double|float", "double");
+    parser.addOption(precisionOption);
+    QCommandLineOption windowOption("window",
+            "FFT window: hann (default), hamming, bh4 (Blackman-Harris), "
+            "flattop or kaiser[:beta] (default beta 9).", "type", "hann");
+    parser.addOption(windowOption);
+    QCommandLineOption plotOption("plot",
+            "Spectrum renderer: threaded (default, render thread + blit), trace "
+            "(GUI thread, buffered layer) or graph (stock QCPGraph, for replot "
+            "time comparisons).", "threaded|trace|graph", "threaded");
+    parser.addOption(plotOption);
+    QCommandLineOption maxFpsOption("max-fps",
+            "Redraw at most this often; spectra are drawn as they arrive "
+            "(default 30).", "fps", "30");
+    parser.addOption(maxFpsOption);
+    QCommandLineOption idleFpsOption("idle-fps",
+            "Redraw rate while the spectrum is steady (default 2).", "fps", "2");
+    parser.addOption(idleFpsOption);
+    QCommandLineOption idleThresholdOption("idle-threshold",
+            "Largest per-bin change, in dB, that still counts as steady "
+            "(default 1, 0 = never idle).", "dB", "1");
+    parser.addOption(idleThresholdOption);
+    QCommandLineOption noWaterfallOption("no-waterfall",
+            "Don't show the spectrogram under the trace.");
+    parser.addOption(noWaterfallOption);
+    QCommandLineOption persistenceOption("persistence",
+            "Show how often the trace hit each pixel behind it, fading with "
+            "a half-life of this many spectra (default 0 = off). Every FFT "
+            "frame is counted, so --averages is 1 while it's on.", "spectra", "0");
+    parser.addOption(persistenceOption);
+    QCommandLineOption latencyOption("latency",
+            "Show per-stage latency, from sample capture to the screen, over the plot.");
+    parser.addOption(latencyOption);
+    QCommandLineOption latencyDumpOption("latency-dump",
+            "Write the latency histograms to <file> every 10 s and on exit.", "file");
+    parser.addOption(latencyDumpOption);
+    QCommandLineOption statsOption("stats",
+            "Start with the Stats overlay on: per-stage timings and CPU% over the plot.");
+    parser.addOption(statsOption);
+    QCommandLineOption headlessOption("headless",
+            "No GUI: write every spectrum to --output as framed binary records "
+            "(see spectrumwriter.h) until the source ends or SIGINT/SIGTERM.");
+    parser.addOption(headlessOption);
+    QCommandLineOption outputOption("output",
+            "Headless output: - for stdout (default), a file or a named pipe.",
+            "path", "-");
+    parser.addOption(outputOption);
+    QCommandLineOption formatOption("format",
+            "Headless bin format: f32 (float32 dB, default) or i16 "
+            "(int16 hundredths of a dB, half the size).", "f32|i16", "f32");
+    parser.addOption(formatOption);
+    QCommandLineOption spectraOption("spectra",
+            "Headless: stop after this many spectra (default 0 = no limit).", "n", "0");
+    parser.addOption(spectraOption);
+    parser.process(*app);
 
-    MainWindow window;
+    DSPConfig config;
+    config.sourceSpec = parser.value(sourceOption);
+    config.fftSize = parser.value(fftSizeOption).toInt();
+    config.hopSize = parser.value(hopOption).toInt();
+    if (config.fftSize < DSPThread::MIN_FFT_SIZE || config.fftSize > DSPThread::MAX_FFT_SIZE) {
+        qWarning("--fft-size must be %d-%d, using 1024", DSPThread::MIN_FFT_SIZE, DSPThread::MAX_FFT_SIZE);
+        config.fftSize = 1024;
+    }
+    if (config.hopSize < 0) {
+        qWarning("--hop must be positive, using --overlap");
+        config.hopSize = 0;
+    }
+
+    double overlap = parser.value(overlapOption).toDouble();
+    if (overlap != 0.0 && overlap != 50.0 && overlap != 75.0 && overlap != 87.5) {
+        qWarning("--overlap must be 0, 50, 75 or 87.5, using 0");
+        overlap = 0.0;
+    }
+    config.overlap = overlap / 100.0;
+    config.averages = qMax(0, parser.value(averagesOption).toInt());
+
+    QString detector = parser.value(detectorOption);
+    if (detector == "peak") {
+        config.detector = DSPConfig::PeakHold;
+    } else if (detector != "avg") {
+        qWarning("--detector must be avg or peak, using avg");
+    }
+
+    QString planner = parser.value(plannerOption);
+    if (planner == "estimate") {
+        config.planEffort = FFTPlanCache::Estimate;
+    } else if (planner == "patient") {
+        config.planEffort = FFTPlanCache::Patient;
+    } else if (planner != "measure") {
+        qWarning("--fft-planner must be estimate, measure or patient, using measure");
+    }
+    config.wisdomPath = parser.value(wisdomOption);
+
+    if (!WindowTable::parse(parser.value(windowOption), &config.window, &config.windowParameter)) {
+        qWarning("--window must be hann, hamming, bh4, flattop or kaiser[:beta], using hann");
+        config.window = WindowTable::Hann;
+        config.windowParameter = 0.0;
+    }
+
+    QString precision = parser.value(precisionOption);
+    if (precision == "float") {
+        config.precision = FFTPlanCache::Float;
+    } else if (precision != "double") {
+        qWarning("--precision must be double or float, using double");
+    }
+
+    if (headless) {
+        // Spectra of the fallback tone look like data to whoever reads
+        // the stream; ask for gen/sim explicitly to record it
+        config.testToneFallback = false;
+        HeadlessConfig output;
+        output.output = parser.value(outputOption);
+        QString format = parser.value(formatOption);
+        if (format == "i16") {
+            output.format = SpectrumWriter::Int16;
+        } else if (format != "f32") {
+            qWarning("--format must be f32 or i16, using f32");
+        }
+        output.spectra = parser.value(spectraOption).toULongLong();
+        return runHeadless(config, output);
+    }
+
+    MainWindow::DisplayConfig display;
+    QString plot = parser.value(plotOption);
+    if (plot == "trace") {
+        display.renderer = MainWindow::TraceRenderer;
+    } else if (plot == "graph") {
+        display.renderer = MainWindow::GraphRenderer;
+    } else if (plot != "threaded") {
+        qWarning("--plot must be threaded, trace or graph, using threaded");
+    }
+
+    display.maxFps = parser.value(maxFpsOption).toDouble();
+    if (display.maxFps <= 0.0) {
+        qWarning("--max-fps must be positive, using 30");
+        display.maxFps = 30.0;
+    }
+    display.idleFps = qBound(0.1, parser.value(idleFpsOption).toDouble(), display.maxFps);
+    display.idleThresholdDb = qMax(0.0, parser.value(idleThresholdOption).toDouble());
+    display.waterfall = !parser.isSet(noWaterfallOption);
+    display.persistenceHalfLife = qMax(0, parser.value(persistenceOption).toInt());
+    if (display.persistenceHalfLife > 0 && config.averages != 1) {
+        // The counts are fed with published spectra; averaging overlapped
+        // frames into one would smear short transients before they land
+        if (config.averages > 1) {
+            qWarning("--persistence counts every frame, ignoring --averages");
+        }
+        config.averages = 1;
+    }
+    display.latencyOverlay = parser.isSet(latencyOption);
+    display.latencyDump = parser.value(latencyDumpOption);
+    display.profileOverlay = parser.isSet(statsOption);
+
+    MainWindow window(config, display);
     window.showFullScreen();  // For BeagleBone display
 
-    return app.exec();
+    return app->exec();
 }
@@ -1,21 +1,105 @@
 #include "mainwindow.h"
+#include "profiler.h"
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <algorithm>
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(const DSPConfig &config, const DisplayConfig &display, QWidget *parent)
         : QMainWindow(parent)
+        , m_scheduler(display.maxFps, display.idleFps, display.idleThresholdDb)
+        , m_spectrumNotified(false)
+        , m_pendingDue(0)
+        , m_renderer(display.renderer)
+        , m_trace(nullptr)
+        , m_replots(0)
+        , m_traceLayer(nullptr)
+        , m_fullReplot(true)
+        , m_fullReplots(0)
+        , m_layerDrawNs(0)
+        , m_renderThread(nullptr)
+        , m_view(nullptr)
+        , m_showWaterfall(display.waterfall)
+        , m_waterfallRect(nullptr)
+        , m_waterfallPlot(nullptr)
+        , m_persistenceHalfLife(display.persistenceHalfLife)
+        , m_persistencePlot(nullptr)
+        , m_traceLatency(display.latencyOverlay || !display.latencyDump.isEmpty())
+        , m_latencyTimer(nullptr)
+        , m_latencyLabel(nullptr)
+        , m_latencyDump(display.latencyDump)
+        , m_latencyTicks(0)
+        , m_replotPickupNs(0)
+        , m_profileMonitor(nullptr)
+        , m_profileLabel(nullptr)
+        , m_replotStartNs(0)
 {
+    Profiler::registerThread("gui");
+
     // Create central widget
     QWidget *centralWidget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(centralWidget);
 
-    // Create plot
+    // Create plot; with the render thread it only draws the background
+    // offscreen and a SpectrumView takes its place (added below)
     m_plot = new QCustomPlot(this);
-    layout->addWidget(m_plot);
+    if (m_renderer == ThreadedRenderer) {
+        m_plot->hide();
+    } else {
+        layout->addWidget(m_plot);
+    }
+
+    // Controls row: FFT size selector and Reset button
+    QHBoxLayout *controls = new QHBoxLayout;
+    layout->addLayout(controls);
+
+    m_fftSizeCombo = new QComboBox(this);
+    for (int n = DSPThread::MIN_FFT_SIZE; n <= DSPThread::MAX_FFT_SIZE; n *= 2) {
+        m_fftSizeCombo->addItem(QString("FFT %1").arg(n), n);
+    }
+    int index = m_fftSizeCombo->findData(config.fftSize);
+    if (index < 0) {
+        // Non power of two from the command line
+        m_fftSizeCombo->addItem(QString("FFT %1").arg(config.fftSize), config.fftSize);
+        index = m_fftSizeCombo->count() - 1;
+    }
+    m_fftSizeCombo->setCurrentIndex(index);
+    controls->addWidget(m_fftSizeCombo);
+
+    // Window selector; item data is the WindowTable::parse() spec
+    m_windowCombo = new QComboBox(this);
+    m_windowCombo->addItem("Hann", "hann");
+    m_windowCombo->addItem("Hamming", "hamming");
+    m_windowCombo->addItem("Blackman-Harris", "bh4");
+    m_windowCombo->addItem("Flat-top", "flattop");
+    m_windowCombo->addItem("Kaiser 9", "kaiser:9");
+    switch (config.window) {
+    case WindowTable::Hann:            m_windowCombo->setCurrentIndex(0); break;
+    case WindowTable::Hamming:         m_windowCombo->setCurrentIndex(1); break;
+    case WindowTable::BlackmanHarris4: m_windowCombo->setCurrentIndex(2); break;
+    case WindowTable::FlatTop:         m_windowCombo->setCurrentIndex(3); break;
+    case WindowTable::Kaiser:
+        if (config.windowParameter != 9.0) {
+            m_windowCombo->addItem(QString("Kaiser %1").arg(config.windowParameter),
+                                   QString("kaiser:%1").arg(config.windowParameter));
+            m_windowCombo->setCurrentIndex(m_windowCombo->count() - 1);
+        } else {
+            m_windowCombo->setCurrentIndex(4);
+        }
+        break;
+    }
+    controls->addWidget(m_windowCombo);
+
+    // Per-stage timings and CPU% over the plot
+    m_statsButton = new QPushButton("Stats", this);
+    m_statsButton->setCheckable(true);
+    controls->addWidget(m_statsButton);
 
-    // Create Reset button
     m_resetButton = new QPushButton("Reset Display", this);
-    layout->addWidget(m_resetButton);
+    controls->addWidget(m_resetButton, 1);
     connect(m_resetButton, &QPushButton::clicked,
             this, &MainWindow::onResetDisplayClicked);
 
@@ -24,13 +108,77 @@ MainWindow::MainWindow(QWidget *parent)
     setupPlot();
 
     // Create and start DSP thread
-    m_dspThread = new DSPThread(this);
-    connect(m_dspThread, &DSPThread::spectrumReady,
-            this, &MainWindow::cacheSpectrum, Qt::QueuedConnection);
-    // UI refresh timer (~30Hz)
+    m_dspThread = new DSPThread(config, this);
+    if (m_renderer == ThreadedRenderer) {
+        // wait() wakes the render thread; every queued frame scrolls the
+        // waterfall, the newest is the trace candidate
+        m_renderThread = new SpectrumRenderer(
+                    m_dspThread->bus().subscribe("render", SpectrumSubscription::Queue, 16), this);
+        m_renderThread->setPen(QPen(QColor(0, 255, 0), 2));
+        m_renderThread->setRefresh(display.maxFps, display.idleFps, display.idleThresholdDb);
+        m_renderThread->setPersistence(display.persistenceHalfLife);
+        m_view = new SpectrumView(m_renderThread, this);
+        m_view->setBackgroundColor(QColor(20, 20, 20));
+        layout->insertWidget(0, m_view, 1);
+        connect(m_view, &SpectrumView::resized, this, &MainWindow::renderBackground);
+    } else {
+        m_spectra = m_dspThread->bus().subscribe("ui", SpectrumSubscription::LatestOnly);
+        if (m_waterfallPlot || m_persistencePlot) {
+            // Drained on each wakeup below; no notifier of its own
+            m_historySpectra = m_dspThread->bus().subscribe("history", SpectrumSubscription::Queue, 64);
+        }
+        // Wake the GUI thread per spectrum, with at most one wakeup queued
+        m_spectra->setNotifier([this] {
+            if (!m_spectrumNotified.exchange(true)) {
+                QMetaObject::invokeMethod(this, "onSpectrumAvailable", Qt::QueuedConnection);
+            }
+        });
+    }
+    connect(m_fftSizeCombo, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFFTSizeChanged);
+    connect(m_windowCombo, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onWindowChanged);
     m_uiTimer = new QTimer(this);
-    connect(m_uiTimer, &QTimer::timeout, this, &MainWindow::refreshPlot);
-    m_uiTimer->start(33);
+    if (m_renderThread) {
+        // Frames arrive through SpectrumView; the timer only reports
+        connect(m_uiTimer, &QTimer::timeout, this, &MainWindow::reportRenderStats);
+        m_uiTimer->start(5000);
+        m_renderThread->start();
+    } else {
+        // Deferred draws only; arrivals come through onSpectrumAvailable()
+        m_uiTimer->setSingleShot(true);
+        connect(m_uiTimer, &QTimer::timeout, this, &MainWindow::schedulePending);
+        m_clock.start();
+    }
+
+    // Full replots (GUI thread renderers) are timed and traced around
+    // QCustomPlot's own signals
+    if (!m_view) {
+        connect(m_plot, &QCustomPlot::beforeReplot, this, &MainWindow::onBeforeReplot);
+        connect(m_plot, &QCustomPlot::afterReplot, this, &MainWindow::onAfterReplot);
+    }
+
+    if (m_traceLatency) {
+        if (m_view) {
+            m_view->setLatencyStats(&m_latency);
+        }
+        if (display.latencyOverlay) {
+            // Over the top right corner of the plot
+            m_latencyLabel = createOverlay();
+        }
+        m_latencyTimer = new QTimer(this);
+        connect(m_latencyTimer, &QTimer::timeout, this, &MainWindow::updateLatency);
+        m_latencyTimer->start(1000);
+    }
+
+    // The monitor idles until the Stats button turns profiling on
+    m_profileLabel = createOverlay();
+    m_profileMonitor = new ProfileMonitor(this);
+    connect(m_profileMonitor, &ProfileMonitor::updated, this, &MainWindow::updateProfile);
+    connect(m_statsButton, &QPushButton::toggled, this, &MainWindow::onStatsToggled);
+    m_statsButton->setChecked(display.profileOverlay);
+    m_profileMonitor->start(QThread::IdlePriority);
+
     m_dspThread->start();
 }
 
@@ -38,28 +186,120 @@ MainWindow::~MainWindow() {
     if (m_dspThread) {
         m_dspThread->stop();
     }
+    // Its subscription holds pooled frames, so it has to go before the
+    // DSP thread (and its pool) is deleted along with the other children
+    delete m_renderThread;
+    m_profileMonitor->stop();
+
+    if (!m_latencyDump.isEmpty()) {
+        m_latencyTotal.merge(m_latency);
+        if (!m_latencyTotal.dump(m_latencyDump.toStdString())) {
+            qWarning() << "Cannot write latency histograms to" << m_latencyDump;
+        }
+    }
 }
 
-void MainWindow::cacheSpectrum(const SpectrumData &data) {
-    QMutexLocker locker(&m_spectrumMutex);
-    m_cachedSpectrum = data;
-    m_hasCachedSpectrum = true;
+void MainWindow::onSpectrumAvailable() {
+    // Clear first: a spectrum published from here on queues a new call
+    m_spectrumNotified = false;
+    if (m_historySpectra) {
+        while (SpectrumFrameRef frame = m_historySpectra->take()) {
+            if (m_waterfallPlot) {
+                m_waterfallPlot->addSpectrum(*frame);
+            }
+            if (m_persistencePlot) {
+                m_persistencePlot->addSpectrum(*frame);
+            }
+        }
+    }
+    SpectrumFrameRef spectrum = m_spectra->take();
+    if (!spectrum)
+        return;
+
+    m_pendingDue = m_scheduler.drawTime(*spectrum);
+    if (m_pendingDue == RefreshScheduler::NEVER) {
+        return;
+    }
+    m_pending = spectrum;
+    schedulePending();
 }
 
-void MainWindow::refreshPlot() {
-    if (!m_hasCachedSpectrum)
+void MainWindow::schedulePending() {
+    if (!m_pending)
         return;
 
-    SpectrumData localCopy;
+    uint64_t now = m_clock.nsecsElapsed();
+    if (now >= m_pendingDue) {
+        m_uiTimer->stop();
+        refreshPlot();
+    } else {
+        // Restarted, so a newer spectrum that may go sooner isn't held up
+        m_uiTimer->start((int)((m_pendingDue - now + 999999) / 1000000));
+    }
+}
+
+void MainWindow::refreshPlot() {
+    uint64_t pickupNs = m_traceLatency ? LatencyStats::nowNs() : 0;
+
+    // The spectrum the scheduler let through
+    SpectrumFrameRef spectrum = m_pending;
+    m_pending.reset();
+    m_scheduler.drawn(*spectrum, m_clock.nsecsElapsed());
+
+    if (m_trace) {
+        // Drawn straight from the frame at replot
+        m_trace->setSpectrum(spectrum);
+    } else {
+        if (m_plotAxis != spectrum->axis) {
+            m_plotAxis = spectrum->axis;
+            m_plotKeys.resize(m_plotAxis->size());
+            std::copy(m_plotAxis->data(), m_plotAxis->data() + m_plotAxis->size(), m_plotKeys.begin());
+        }
+        m_plotValues.resize(spectrum->numBins);
+        std::copy(spectrum->magnitudes, spectrum->magnitudes + spectrum->numBins, m_plotValues.begin());
 
-    { QMutexLocker locker(&m_spectrumMutex);
-      localCopy = m_cachedSpectrum;
+        m_plot->graph(0)->setData(m_plotKeys, m_plotValues, true);
     }
 
-    m_plot->graph(0)->setData(localCopy.frequencies,
-                              localCopy.magnitudes);
+    if (m_traceLayer && !m_fullReplot) {
+        QElapsedTimer timer;
+        timer.start();
+        m_traceLayer->replot();
+        uint64_t elapsed = timer.nsecsElapsed();
+        Profiler::record(Profiler::Replot, elapsed);
+        m_layerDrawNs += elapsed;
+        if (pickupNs) {
+            // The layer's buffer is done; the next paint only composites it
+            m_latency.record(spectrum->times, pickupNs, LatencyStats::nowNs());
+        }
+    } else {
+        m_fullReplot = false;
+        m_fullReplots++;
+        m_plot->replot(QCustomPlot::rpQueuedReplot);
+        if (pickupNs) {
+            // Recorded by onAfterReplot(); a newer spectrum drawn before
+            // the queued replot runs replaces this one
+            m_replotTimes = spectrum->times;
+            m_replotPickupNs = pickupNs;
+        }
+    }
 
-    m_plot->replot(QCustomPlot::rpQueuedReplot);
+    // Every 150 redraws. replotTime() is QCustomPlot's own moving average
+    // over the last ~10 full replots.
+    if (++m_replots >= 150) {
+        if (m_traceLayer) {
+            int layerDraws = m_replots - m_fullReplots;
+            qDebug() << "UI - trace layer" << (layerDraws ? m_layerDrawNs / 1e6 / layerDraws : 0.0)
+                     << "ms avg," << m_fullReplots << "full replots (" << m_plot->replotTime(true)
+                     << "ms avg )," << spectrum->numBins << "bins";
+        } else {
+            qDebug() << "UI - replot" << m_plot->replotTime(true) << "ms avg, QCPGraph,"
+                     << spectrum->numBins << "bins";
+        }
+        m_replots = 0;
+        m_fullReplots = 0;
+        m_layerDrawNs = 0;
+    }
 }
 
 void MainWindow::setupPlot() {
@@ -109,9 +349,184 @@ void MainWindow::setupPlot() {
     m_plot->xAxis->grid()->setPen(QPen(QColor(60, 60, 60), 1, Qt::DotLine));
     m_plot->yAxis->grid()->setPen(QPen(QColor(60, 60, 60), 1, Qt::DotLine));
 
-    // Add graph
-    m_plot->addGraph();
-    m_plot->graph(0)->setPen(QPen(QColor(0, 255, 0), 2));  // Green, 2px
+    // Persistence counts under the trace, added first so the trace draws
+    // over them on a shared layer
+    if (m_persistenceHalfLife > 0 && m_renderer != ThreadedRenderer) {
+        m_persistencePlot = new PersistencePlot(m_plot->xAxis, m_plot->yAxis);
+        m_persistencePlot->persistence().setHalfLife(m_persistenceHalfLife);
+    }
+
+    // Spectrum trace
+    QPen tracePen(QColor(0, 255, 0), 2);  // Green, 2px
+    if (m_renderer == TraceRenderer) {
+        m_trace = new SpectrumTrace(m_plot->xAxis, m_plot->yAxis);
+        m_trace->setPen(tracePen);
+
+        // Own paint buffer above "main"; everything else stays cached in
+        // the buffers below and above it
+        m_plot->addLayer("spectrum", m_plot->layer("main"), QCustomPlot::limAbove);
+        m_traceLayer = m_plot->layer("spectrum");
+        m_traceLayer->setMode(QCPLayer::lmBuffered);
+        if (m_persistencePlot) {
+            m_persistencePlot->setLayer(m_traceLayer);
+        }
+        m_trace->setLayer(m_traceLayer);
+    } else if (m_renderer == GraphRenderer) {
+        m_plot->addGraph();
+        m_plot->graph(0)->setPen(tracePen);
+    }
+
+    if (m_showWaterfall) {
+        // Spectrogram under the trace: same frequency axis, left and right
+        // edges lined up with the trace's, newest row at the top
+        m_waterfallRect = new QCPAxisRect(m_plot);
+        m_plot->plotLayout()->addElement(1, 0, m_waterfallRect);
+        m_plot->plotLayout()->setRowStretchFactor(1, 0.6);
+        QCPMarginGroup *margins = new QCPMarginGroup(m_plot);
+        m_plot->axisRect()->setMarginGroup(QCP::msLeft | QCP::msRight, margins);
+        m_waterfallRect->setMarginGroup(QCP::msLeft | QCP::msRight, margins);
+
+        QCPAxis *key = m_waterfallRect->axis(QCPAxis::atBottom);
+        key->setScaleType(QCPAxis::stLogarithmic);
+        key->setRange(m_plot->xAxis->range());
+        key->setTicker(textTicker);
+        key->setTickLabels(false);
+        key->setTickLength(5, 2);
+        key->setBasePen(QPen(Qt::white));
+        key->setTickPen(QPen(Qt::white));
+        key->grid()->setVisible(false);
+        connect(m_plot->xAxis, static_cast<void (QCPAxis::*)(const QCPRange&)>(&QCPAxis::rangeChanged),
+                key, static_cast<void (QCPAxis::*)(const QCPRange&)>(&QCPAxis::setRange));
+
+        QCPAxis *time = m_waterfallRect->axis(QCPAxis::atLeft);
+        time->setLabel("Time");
+        time->setLabelColor(Qt::white);
+        time->setTickLabels(false);
+        time->setTicks(false);
+        time->setBasePen(QPen(Qt::white));
+        time->grid()->setVisible(false);
+
+        if (m_renderer != ThreadedRenderer) {
+            m_waterfallPlot = new WaterfallPlot(key, time);
+            if (m_traceLayer) {
+                m_waterfallPlot->setLayer(m_traceLayer);
+            }
+        }
+    }
+
+    connect(m_plot->xAxis, static_cast<void (QCPAxis::*)(const QCPRange&)>(&QCPAxis::rangeChanged),
+            this, &MainWindow::invalidatePlot);
+    connect(m_plot->yAxis, static_cast<void (QCPAxis::*)(const QCPRange&)>(&QCPAxis::rangeChanged),
+            this, &MainWindow::invalidatePlot);
+}
+
+void MainWindow::invalidatePlot() {
+    m_fullReplot = true;
+    if (m_view) {
+        renderBackground(m_view->size());
+    }
+}
+
+void MainWindow::renderBackground(const QSize &size) {
+    if (size.isEmpty()) {
+        return;
+    }
+
+    // Lay the hidden plot out at the view's size and keep it there, so the
+    // axis rect read back below matches the image
+    m_plot->setViewport(QRect(QPoint(0, 0), size));
+    QImage background = m_plot->toPixmap(size.width(), size.height()).toImage()
+                                .convertToFormat(QImage::Format_RGB32);
+
+    RenderGeometry geometry;
+    geometry.plotRect = m_plot->axisRect()->rect();
+    geometry.keyLower = m_plot->xAxis->range().lower;
+    geometry.keyUpper = m_plot->xAxis->range().upper;
+    geometry.keyLogarithmic = m_plot->xAxis->scaleType() == QCPAxis::stLogarithmic;
+    geometry.valueLower = m_plot->yAxis->range().lower;
+    geometry.valueUpper = m_plot->yAxis->range().upper;
+    if (m_waterfallRect) {
+        geometry.waterfallRect = m_waterfallRect->rect();
+    }
+    m_renderThread->setBackground(background, geometry);
+}
+
+void MainWindow::reportRenderStats() {
+    uint64_t received, frames, renderNs;
+    m_renderThread->takeStats(&received, &frames, &renderNs);
+    uint64_t blits = m_view->blits(), blitNs = m_view->blitNs();
+    m_view->resetStats();
+
+    qDebug() << "UI - render" << (frames ? renderNs / 1e6 / frames : 0.0) << "ms avg x" << frames
+             << "of" << received << "spectra (render thread) | blit"
+             << (blits ? blitNs / 1e6 / blits : 0.0) << "ms avg x" << blits << "(GUI thread)";
+}
+
+void MainWindow::onBeforeReplot() {
+    m_replotStartNs = Profiler::enabled() ? Profiler::nowNs() : 0;
+}
+
+void MainWindow::onAfterReplot() {
+    if (m_replotStartNs) {
+        Profiler::record(Profiler::Replot, Profiler::nowNs() - m_replotStartNs);
+        m_replotStartNs = 0;
+    }
+    if (m_replotPickupNs) {
+        m_latency.record(m_replotTimes, m_replotPickupNs, LatencyStats::nowNs());
+        m_replotPickupNs = 0;
+    }
+}
+
+void MainWindow::onStatsToggled(bool on) {
+    Profiler::setEnabled(on);
+    if (!on) {
+        m_profileLabel->hide();
+    }
+}
+
+void MainWindow::updateProfile() {
+    if (!m_statsButton->isChecked()) {
+        return;   // switched off while this was queued
+    }
+    m_profileLabel->setText(m_profileMonitor->text());
+    m_profileLabel->adjustSize();
+    m_profileLabel->move(8, 8);
+    m_profileLabel->show();
+}
+
+// Hidden text box over the plot, whichever widget shows it
+QLabel* MainWindow::createOverlay() {
+    QWidget *plotWidget = m_view ? static_cast<QWidget*>(m_view) : m_plot;
+    QLabel *label = new QLabel(plotWidget);
+    label->setAutoFillBackground(true);
+    QPalette palette = label->palette();
+    palette.setColor(QPalette::Window, QColor(0, 0, 0, 180));
+    palette.setColor(QPalette::WindowText, Qt::white);
+    label->setPalette(palette);
+    label->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    label->setAttribute(Qt::WA_TransparentForMouseEvents);
+    label->setContentsMargins(4, 2, 4, 2);
+    label->hide();
+    return label;
+}
+
+void MainWindow::updateLatency() {
+    if (m_latencyLabel) {
+        m_latencyLabel->setText(QString::fromStdString(m_latency.summary()));
+        m_latencyLabel->adjustSize();
+        QWidget *plotWidget = m_latencyLabel->parentWidget();
+        m_latencyLabel->move(plotWidget->width() - m_latencyLabel->width() - 8, 8);
+        m_latencyLabel->show();
+    }
+    m_latencyTotal.merge(m_latency);
+    m_latency.clear();
+
+    if (!m_latencyDump.isEmpty() && ++m_latencyTicks >= 10) {
+        m_latencyTicks = 0;
+        if (!m_latencyTotal.dump(m_latencyDump.toStdString())) {
+            qWarning() << "Cannot write latency histograms to" << m_latencyDump;
+        }
+    }
 }
 
 /*
@@ -145,9 +560,33 @@ void MainWindow::onResetDisplayClicked() {
         for (int i = 0; i < m_plot->graphCount(); ++i) {
             m_plot->graph(i)->data()->clear();
         }
+    }
+    if (m_trace) {
+        m_trace->clear();
+    }
+    if (m_waterfallPlot) {
+        m_waterfallPlot->clear();
+    }
+    if (m_persistencePlot) {
+        m_persistencePlot->clear();
+    }
+    if (m_plot) {
         m_plot->replot();
     }
 
     // Quit the application 
     QCoreApplication::quit();
-}
\ No newline at end of file
+}
+
+void MainWindow::onFFTSizeChanged(int index) {
+    // Picked up by the DSP thread once the plan for this size is ready
+    m_dspThread->setFFTSize(m_fftSizeCombo->itemData(index).toInt());
+}
+
+void MainWindow::onWindowChanged(int index) {
+    WindowTable::Type type;
+    double parameter;
+    if (WindowTable::parse(m_windowCombo->itemData(index).toString(), &type, &parameter)) {
+        m_dspThread->setWindow(type, parameter);
+    }
+}
@@ -5,35 +5,145 @@
 #include "qcustomplot.h"
 #include "dspthread.h"
 #include "spectrumdata.h"
+#include "spectrumtrace.h"
+#include "spectrumview.h"
+#include "refreshscheduler.h"
+#include "waterfallplot.h"
+#include "persistenceplot.h"
+#include "latencystats.h"
+#include "profilemonitor.h"
 #include <QPushButton>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QLabel>
+#include <QComboBox>
+#include <QElapsedTimer>
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // How spectra are drawn:
+    //   Threaded  SpectrumRenderer thread rasterizes, the GUI thread blits
+    //   Trace     SpectrumTrace on a buffered QCustomPlot layer, GUI thread
+    //   Graph     stock QCPGraph::setData + replot, for comparisons
+    enum PlotRenderer {
+        ThreadedRenderer,
+        TraceRenderer,
+        GraphRenderer
+    };
+
+    // Display settings (command line, see main.cpp)
+    struct DisplayConfig {
+        PlotRenderer renderer;
+        double maxFps;            // redraw cap
+        double idleFps;           // redraw rate while the spectrum is steady
+        double idleThresholdDb;   // max per-bin change that counts as steady
+        bool waterfall;           // spectrogram under the trace
+        int persistenceHalfLife;  // spectra; 0: no persistence display
+        bool latencyOverlay;      // per-stage latency, capture to screen, on the plot
+        QString latencyDump;      // file the latency histograms are written to
+        bool profileOverlay;      // start with the Stats overlay on
+
+        DisplayConfig() : renderer(ThreadedRenderer), maxFps(30.0), idleFps(2.0),
+                          idleThresholdDb(1.0), waterfall(true), persistenceHalfLife(0),
+                          latencyOverlay(false), profileOverlay(false) {}
+    };
+
+    explicit MainWindow(const DSPConfig &config = DSPConfig(),
+                        const DisplayConfig &display = DisplayConfig(), QWidget *parent = nullptr);
     ~MainWindow();
 
 private slots:
-            // void updateSpectrum(const SpectrumData &data);
-	    void cacheSpectrum(const SpectrumData &data);
             void onResetDisplayClicked();
+            void onFFTSizeChanged(int index);
+            void onWindowChanged(int index);
+            void onSpectrumAvailable();
+            void onStatsToggled(bool on);
 
 private:
     void setupPlot();
+    void schedulePending();
     void refreshPlot();
+    void invalidatePlot();
+    void renderBackground(const QSize &size);
+    void reportRenderStats();
+    void onBeforeReplot();
+    void onAfterReplot();
+    void updateLatency();
+    void updateProfile();
+    QLabel* createOverlay();
 
     QCustomPlot *m_plot;
     DSPThread *m_dspThread;
+    SpectrumSubscriptionPtr m_spectra;   // latest-only, GUI thread renderers
     QPushButton *m_resetButton;
+    QPushButton *m_statsButton;
+    QComboBox *m_fftSizeCombo;
+    QComboBox *m_windowCombo;
 
-    QMutex m_spectrumMutex;
-    SpectrumData m_cachedSpectrum;
-    bool m_hasCachedSpectrum;
-
+    // Trace and Graph: a new spectrum is drawn when it arrives, or when
+    // m_uiTimer (single shot) fires at the time m_scheduler allows
     QTimer *m_uiTimer;
+    RefreshScheduler m_scheduler;
+    QElapsedTimer m_clock;
+    std::atomic<bool> m_spectrumNotified;   // an onSpectrumAvailable() is queued
+    SpectrumFrameRef m_pending;             // newest spectrum not drawn yet
+    uint64_t m_pendingDue;
+
+    PlotRenderer m_renderer;
+    SpectrumTrace *m_trace;
+    int m_replots;   // spectra drawn since the last replot time report
+
+    // TraceRenderer: the trace has a buffered layer of its own, so a new
+    // spectrum only redraws that layer and the cached background, grid and
+    // axes are just composited. Full replots happen on resize (QCustomPlot
+    // does those itself) and on axis range changes.
+    QCPLayer *m_traceLayer;
+    bool m_fullReplot;
+    int m_fullReplots;
+    qint64 m_layerDrawNs;
+
+    // ThreadedRenderer: m_plot stays hidden and only renders the static
+    // background (axes, grid, labels) for m_renderThread at m_view's size
+    SpectrumRenderer *m_renderThread;
+    SpectrumView *m_view;
+
+    // Spectrogram axis rect under the trace's, and persistence counts
+    // behind the trace. Both take every spectrum, whatever the refresh
+    // rate: GUI thread renderers drain m_historySpectra into the plots,
+    // the render thread keeps its own.
+    bool m_showWaterfall;
+    QCPAxisRect *m_waterfallRect;
+    WaterfallPlot *m_waterfallPlot;
+    int m_persistenceHalfLife;
+    PersistencePlot *m_persistencePlot;
+    SpectrumSubscriptionPtr m_historySpectra;
+
+    // Latency tracing, when the overlay or the dump is on: spectra are
+    // recorded into m_latency as they reach the screen (SpectrumView, or
+    // refreshPlot / the end of a full replot); once a second it goes to
+    // the overlay and is folded into m_latencyTotal, which is dumped
+    // every 10 s and on exit
+    bool m_traceLatency;
+    LatencyStats m_latency;
+    LatencyStats m_latencyTotal;
+    QTimer *m_latencyTimer;
+    QLabel *m_latencyLabel;
+    QString m_latencyDump;
+    int m_latencyTicks;
+    SpectrumTimes m_replotTimes;   // spectrum in the queued full replot
+    uint64_t m_replotPickupNs;     // 0: none
+
+    // Stats overlay (Profiler): the Stats button turns profiling on and
+    // shows m_profileMonitor's text over the top left of the plot
+    ProfileMonitor *m_profileMonitor;
+    QLabel *m_profileLabel;
+    uint64_t m_replotStartNs;      // full replot in progress, while profiling
+
+    // GraphRenderer: QCustomPlot wants QVectors; keys are rebuilt only
+    // when the axis changes
+    FrequencyAxisPtr m_plotAxis;
+    QVector<double> m_plotKeys;
+    QVector<double> m_plotValues;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "persistence.h"
+#include <cmath>
+
+Persistence::Persistence()
+        : m_imageStale(true)
+        , m_keyLower(1.0)
+        , m_keyUpper(2.0)
+        , m_keyLogarithmic(false)
+{
+    setGradient(QCPColorGradient::gpHot);
+}
+
+void Persistence::setGradient(const QCPColorGradient &gradient) {
+    m_gradient = gradient;
+    // Log scaled so a cell hit now and then still shows; premultiplied
+    // with alpha rising over the first entries so faint hits don't hide
+    // the grid
+    m_colors[0] = 0;
+    for (int i = 1; i < 256; i++) {
+        double level = log(1.0 + i) / log(256.0);
+        QColor color = m_gradient.color(level, QCPRange(0.0, 1.0));
+        int alpha = qMin(255, 64 + i * 12);
+        m_colors[i] = qPremultiply(qRgba(color.red(), color.green(), color.blue(), alpha));
+    }
+    m_imageStale = true;
+}
+
+void Persistence::setGeometry(int width, int height, double keyLower, double keyUpper, bool keyLogarithmic,
+                              double valueLower, double valueUpper) {
+    m_grid.setValueRange(valueLower, valueUpper);
+    if (width == m_grid.width() && height == m_grid.height() && keyLower == m_keyLower
+            && keyUpper == m_keyUpper && keyLogarithmic == m_keyLogarithmic) {
+        return;
+    }
+    m_keyLower = keyLower;
+    m_keyUpper = keyUpper;
+    m_keyLogarithmic = keyLogarithmic;
+    m_binXAxis.reset();
+
+    m_grid.resize(qMax(0, width), qMax(0, height));
+    if (m_grid.width() > 0 && m_grid.height() > 0) {
+        m_image = QImage(m_grid.width(), m_grid.height(), QImage::Format_ARGB32_Premultiplied);
+    } else {
+        m_image = QImage();
+    }
+    m_imageStale = true;
+}
+
+void Persistence::clear() {
+    m_grid.clear();
+    m_imageStale = true;
+}
+
+void Persistence::rebuildBinX(const FrequencyAxisPtr &axis) {
+    m_binXAxis = axis;
+    const int bins = axis->size();
+    const double *frequencies = axis->data();
+    const int width = m_grid.width();
+    m_binX.resize(bins);
+    if (m_keyLogarithmic) {
+        const double scale = width / log(m_keyUpper / m_keyLower);
+        for (int i = 0; i < bins; i++) {
+            m_binX[i] = log(frequencies[i] / m_keyLower) * scale;
+        }
+    } else {
+        const double scale = width / (m_keyUpper - m_keyLower);
+        for (int i = 0; i < bins; i++) {
+            m_binX[i] = (frequencies[i] - m_keyLower) * scale;
+        }
+    }
+    m_grid.setBinX(m_binX.data(), bins);
+}
+
+void Persistence::addSpectrum(const SpectrumData &frame) {
+    if (m_image.isNull() || frame.numBins == 0) {
+        return;
+    }
+    if (m_binXAxis != frame.axis) {
+        rebuildBinX(frame.axis);
+    }
+    m_grid.add(frame.magnitudes);
+    m_imageStale = true;
+}
+
+void Persistence::colorize() {
+    // The grid is column-major; rows are written one scanline at a time
+    const int width = m_grid.width(), height = m_grid.height();
+    for (int y = 0; y < height; y++) {
+        QRgb *line = reinterpret_cast<QRgb*>(m_image.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            line[x] = m_colors[m_grid.column(x)[y] >> 8];
+        }
+    }
+    m_imageStale = false;
+}
+
+void Persistence::draw(QPainter *painter, const QRect &target) {
+    if (m_image.isNull()) {
+        return;
+    }
+    if (m_imageStale) {
+        colorize();
+    }
+    QPainter::CompositionMode mode = painter->compositionMode();
+    painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter->drawImage(target.topLeft(), m_image);
+    painter->setCompositionMode(mode);
+}
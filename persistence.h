@@ -0,0 +1,59 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <QImage>
+#include <QPainter>
+#include <vector>
+#include "qcustomplot.h"
+#include "spectrumdata.h"
+#include "persistencegrid.h"
+
+// Persistence (density) display: how often the trace went through each
+// pixel recently, like an RTSA's persistence mode, so intermittent
+// signals stay visible between the frames that happen to be drawn.
+//
+// Every spectrum is rasterized into a PersistenceGrid covering the plot
+// area (main.cpp keeps --averages at 1 while persistence is on, so that is
+// every FFT frame, overlapped ones included); draw() colorizes the counts through a 256 entry table built from
+// the gradient (log scaled, zero hits stay transparent), at the refresh
+// rate and only when something was added.
+//
+// Not thread safe; used by one thread (render thread or GUI thread).
+class Persistence {
+public:
+    Persistence();
+
+    void setGradient(const QCPColorGradient &gradient);
+    void setHalfLife(int spectra) { m_grid.setHalfLife(spectra); }
+
+    // The plot area: one cell per pixel, over the trace's key and value
+    // ranges. Clears the counts when anything changes.
+    void setGeometry(int width, int height, double keyLower, double keyUpper, bool keyLogarithmic,
+                     double valueLower, double valueUpper);
+
+    void addSpectrum(const SpectrumData &frame);
+    void clear();
+
+    const PersistenceGrid& grid() const { return m_grid; }
+
+    // Draws the colorized counts unscaled with their top left corner at
+    // target's
+    void draw(QPainter *painter, const QRect &target);
+
+private:
+    void rebuildBinX(const FrequencyAxisPtr &axis);
+    void colorize();
+
+    PersistenceGrid m_grid;
+    QCPColorGradient m_gradient;
+    QRgb m_colors[256];   // by count >> 8
+    QImage m_image;       // Format_ARGB32_Premultiplied
+    bool m_imageStale;
+
+    double m_keyLower, m_keyUpper;
+    bool m_keyLogarithmic;
+    FrequencyAxisPtr m_binXAxis;
+    std::vector<double> m_binX;
+};
+
+#endif
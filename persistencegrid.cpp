@@ -0,0 +1,146 @@
+#include "persistencegrid.h"
+#include <algorithm>
+#include <cmath>
+
+PersistenceGrid::PersistenceGrid()
+        : m_width(0)
+        , m_height(0)
+        , m_halfLife(0)
+        , m_decayInterval(1)
+        , m_sinceDecay(0)
+        , m_weight(1)
+        , m_lower(-80.0)
+        , m_upper(0.0)
+        , m_spectra(0)
+{
+    setHalfLife(48);
+}
+
+void PersistenceGrid::resize(int width, int height) {
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+    m_cells.assign((size_t)m_width * m_height, 0);
+    m_columns.clear();
+    clear();
+}
+
+void PersistenceGrid::setHalfLife(int spectra) {
+    m_halfLife = std::max(1, spectra);
+    // Each decay keeps 3/4: log(1/2) / log(3/4) decays per half-life
+    m_decayInterval = std::max(1, (int)lround(m_halfLife * log(0.75) / log(0.5)));
+    // Hit every time, a cell peaks at 4 x weight x interval just before a decay
+    m_weight = (uint16_t)std::max(1, 0xFFFF / (4 * m_decayInterval));
+    m_sinceDecay = 0;
+}
+
+void PersistenceGrid::setValueRange(double lower, double upper) {
+    if (lower == m_lower && upper == m_upper) {
+        return;
+    }
+    m_lower = lower;
+    m_upper = upper;
+    clear();
+}
+
+void PersistenceGrid::setBinX(const double *binX, int bins) {
+    m_columns.resize(m_width);
+
+    int start = 0;
+    for (int c = 0; c < m_width; c++) {
+        Column &column = m_columns[c];
+        while (start < bins && binX[start] < c) {
+            start++;
+        }
+        int end = start;
+        while (end < bins && binX[end] < c + 1) {
+            end++;
+        }
+        column.start = start;
+        column.count = end - start;
+
+        column.leftBin = -1;
+        column.leftT = 0.0;
+        if (start > 0 && start < bins) {
+            column.leftBin = start - 1;
+            column.leftT = (c - binX[start - 1]) / (binX[start] - binX[start - 1]);
+        }
+        column.rightBin = -1;
+        column.rightT = 0.0;
+        if (end > 0 && end < bins) {
+            column.rightBin = end - 1;
+            column.rightT = (c + 1 - binX[end - 1]) / (binX[end] - binX[end - 1]);
+        }
+    }
+}
+
+void PersistenceGrid::clear() {
+    std::fill(m_cells.begin(), m_cells.end(), 0);
+    m_sinceDecay = 0;
+    m_spectra = 0;
+}
+
+int PersistenceGrid::row(double db) const {
+    double r = (m_upper - db) * m_height / (m_upper - m_lower);
+    // Clamped before the cast: -inf dB (digital silence) included
+    r = std::max(-1.0, std::min(r, (double)m_height));
+    return (int)floor(r);
+}
+
+void PersistenceGrid::decay() {
+    uint16_t *cells = m_cells.data();
+    const size_t n = m_cells.size();
+    for (size_t i = 0; i < n; i++) {
+        cells[i] -= cells[i] >> 2;
+    }
+}
+
+void PersistenceGrid::add(const double *db) {
+    if (m_columns.empty() || m_height == 0) {
+        return;
+    }
+
+    const uint16_t weight = m_weight;
+    const uint16_t limit = 0xFFFF - weight;
+    for (int c = 0; c < m_width; c++) {
+        const Column &column = m_columns[c];
+        double lo = INFINITY, hi = -INFINITY;
+        for (int i = column.start; i < column.start + column.count; i++) {
+            lo = std::min(lo, db[i]);
+            hi = std::max(hi, db[i]);
+        }
+        if (column.leftBin >= 0) {
+            const double *s = db + column.leftBin;
+            double v = s[0] + (s[1] - s[0]) * column.leftT;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        if (column.rightBin >= 0) {
+            const double *s = db + column.rightBin;
+            double v = s[0] + (s[1] - s[0]) * column.rightT;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        if (lo > hi) {
+            continue;   // outside the bins
+        }
+
+        // Rows grow downwards: the highest dB is the top row
+        int top = row(hi), bottom = row(lo);
+        if (bottom < 0 || top >= m_height) {
+            continue;
+        }
+        top = std::max(top, 0);
+        bottom = std::min(bottom, m_height - 1);
+
+        uint16_t *cells = &m_cells[(size_t)c * m_height];
+        for (int r = top; r <= bottom; r++) {
+            cells[r] = (uint16_t)(std::min(cells[r], limit) + weight);
+        }
+    }
+
+    m_spectra++;
+    if (++m_sinceDecay >= m_decayInterval) {
+        m_sinceDecay = 0;
+        decay();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef PERSISTENCEGRID_H
+#define PERSISTENCEGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hit counts behind the persistence display: a fixed width x height grid
+// of (pixel column, dB row) cells that every spectrum rasterizes into as a
+// polyline, and that decays so old hits fade out.
+//
+// Everything per spectrum is integer work over contiguous memory, so the
+// cost is set by the grid size and not by how many spectra arrive or get
+// drawn:
+//
+//   add     each column's span of rows gets a saturating += weight; cells
+//           are column-major, so a span is a contiguous run (vqadd-shaped
+//           min + add the compiler vectorizes)
+//   decay   every decayInterval() spectra, count -= count >> 2 over the
+//           whole grid, one flat loop; the interval is picked so counts
+//           halve every halfLife spectra
+//
+// The weight is scaled to the interval so a cell hit by every spectrum
+// swings between 3/4 of 0xFFFF (just decayed) and just under 0xFFFF.
+//
+// Qt-free so bench/ can time it; used by one thread.
+class PersistenceGrid {
+public:
+    PersistenceGrid();
+
+    // Clears the counts
+    void resize(int width, int height);
+    void setHalfLife(int spectra);
+    // dB at the top of row 0 and the bottom of the last row; clears
+    void setValueRange(double lower, double upper);
+    // binX[i]: pixel x of bin i relative to column 0, monotonic increasing
+    void setBinX(const double *binX, int bins);
+
+    void add(const double *db);
+    void clear();
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int halfLife() const { return m_halfLife; }
+    int decayInterval() const { return m_decayInterval; }
+    uint16_t weight() const { return m_weight; }
+    uint64_t spectra() const { return m_spectra; }
+
+    // height() counts for column x, row 0 at the top
+    const uint16_t* column(int x) const { return &m_cells[(size_t)x * m_height]; }
+
+private:
+    // What of the polyline falls in a pixel column: its bins, and where the
+    // segments from the neighbouring bins cross the column's edges
+    struct Column {
+        int start, count;         // bins inside the column
+        int leftBin, rightBin;    // segment [bin, bin + 1] crossing an edge; -1: none
+        double leftT, rightT;     // position along that segment
+    };
+
+    void decay();
+    int row(double db) const;
+
+    int m_width, m_height;
+    int m_halfLife;
+    int m_decayInterval;
+    int m_sinceDecay;
+    uint16_t m_weight;
+    double m_lower, m_upper;
+    uint64_t m_spectra;
+
+    std::vector<Column> m_columns;
+    std::vector<uint16_t> m_cells;   // column-major, width x height
+};
+
+#endif
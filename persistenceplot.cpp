@@ -0,0 +1,58 @@
+#include "persistenceplot.h"
+
+PersistencePlot::PersistencePlot(QCPAxis *keyAxis, QCPAxis *valueAxis)
+        : QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    setSelectable(QCP::stNone);
+}
+
+void PersistencePlot::updateGeometry() {
+    QCPAxis *key = mKeyAxis.data();
+    QCPAxis *value = mValueAxis.data();
+    const QRect rect = key->axisRect()->rect();
+    m_persistence.setGeometry(rect.width(), rect.height(), key->range().lower, key->range().upper,
+                              key->scaleType() == QCPAxis::stLogarithmic,
+                              value->range().lower, value->range().upper);
+}
+
+void PersistencePlot::addSpectrum(const SpectrumData &frame) {
+    if (!mKeyAxis || !mValueAxis) {
+        return;
+    }
+    updateGeometry();
+    m_persistence.addSpectrum(frame);
+}
+
+double PersistencePlot::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const {
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+    return -1;
+}
+
+QCPRange PersistencePlot::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const {
+    Q_UNUSED(inSignDomain)
+    foundRange = false;
+    return QCPRange();
+}
+
+QCPRange PersistencePlot::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
+                                      const QCPRange &inKeyRange) const {
+    Q_UNUSED(inSignDomain)
+    Q_UNUSED(inKeyRange)
+    foundRange = false;
+    return QCPRange();
+}
+
+void PersistencePlot::draw(QCPPainter *painter) {
+    if (!mKeyAxis || !mValueAxis) {
+        return;
+    }
+    updateGeometry();
+    m_persistence.draw(painter, mKeyAxis->axisRect()->rect());
+}
+
+void PersistencePlot::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const {
+    Q_UNUSED(painter)
+    Q_UNUSED(rect)
+}
@@ -0,0 +1,37 @@
+#ifndef PERSISTENCEPLOT_H
+#define PERSISTENCEPLOT_H
+
+#include "qcustomplot.h"
+#include "persistence.h"
+
+// QCustomPlot plottable around a Persistence grid, for the GUI thread
+// renderers. Fills its axis rect under the trace; the grid follows that
+// rect's size and both axis ranges (counts are cleared when they change).
+class PersistencePlot : public QCPAbstractPlottable {
+    Q_OBJECT
+
+public:
+    PersistencePlot(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    Persistence& persistence() { return m_persistence; }
+
+    // Every spectrum, drawn or not; shows at the next replot
+    void addSpectrum(const SpectrumData &frame);
+    void clear() { m_persistence.clear(); }
+
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth,
+                           const QCPRange &inKeyRange = QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private:
+    void updateGeometry();
+
+    Persistence m_persistence;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "profilemonitor.h"
+#include "profiler.h"
+#include <QMutexLocker>
+
+ProfileMonitor::ProfileMonitor(QObject *parent)
+        : QThread(parent)
+{
+}
+
+ProfileMonitor::~ProfileMonitor() {
+    stop();
+}
+
+void ProfileMonitor::stop() {
+    requestInterruption();
+    wait();
+}
+
+QString ProfileMonitor::text() const {
+    QMutexLocker locker(&m_mutex);
+    return m_text;
+}
+
+void ProfileMonitor::run() {
+    bool wasEnabled = false;
+    Profiler::Snapshot snapshot;
+
+    while (!isInterruptionRequested()) {
+        // 1 s in short naps, so stop() doesn't wait long
+        for (int i = 0; i < 20 && !isInterruptionRequested(); i++) {
+            msleep(50);
+        }
+
+        bool enabled = Profiler::enabled();
+        if (enabled) {
+            Profiler::collect(&snapshot);
+        }
+        // The first collect after switching on spans the time it was off;
+        // it only resets the baseline
+        if (!enabled || !wasEnabled) {
+            wasEnabled = enabled;
+            continue;
+        }
+
+        QString text = QString::fromStdString(Profiler::format(snapshot));
+        {
+            QMutexLocker locker(&m_mutex);
+            m_text = text;
+        }
+        emit updated();
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef PROFILEMONITOR_H
+#define PROFILEMONITOR_H
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+
+// The Profiler's one reader. Once a second, while profiling is on, it
+// collects the per-thread counters and formats them; the text is picked
+// up after updated(). Runs at IdlePriority (SCHED_IDLE on Linux), so
+// aggregating never takes CPU from the DSP, render or GUI threads.
+class ProfileMonitor : public QThread {
+    Q_OBJECT
+
+public:
+    explicit ProfileMonitor(QObject *parent = nullptr);
+    ~ProfileMonitor();
+
+    // Safe before run() has started: the request is QThread's own flag,
+    // not one run() sets up
+    void stop();
+
+    // Newest Profiler::format() text; any thread
+    QString text() const;
+
+signals:
+    // New text; queued to receivers on other threads
+    void updated();
+
+protected:
+    void run() override;
+
+private:
+    mutable QMutex m_mutex;
+    QString m_text;
+};
+
+#endif
@@ -0,0 +1,174 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+
+std::atomic<bool> Profiler::s_enabled(false);
+std::atomic<int> Profiler::s_claimed(0);
+Profiler::ThreadBlock Profiler::s_blocks[Profiler::MAX_THREADS];
+
+// The calling thread's block; null until it registers or first records,
+// &s_notProfiled once it has been refused one (all MAX_THREADS taken)
+static char s_notProfiled;
+static thread_local void *t_block = nullptr;
+
+// Reader side, only touched by collect()
+static uint32_t s_lastBuckets[Profiler::MAX_THREADS][Profiler::NUM_STAGES][LatencyHistogram::BUCKETS];
+static uint64_t s_lastSumNs[Profiler::MAX_THREADS][Profiler::NUM_STAGES];
+static uint64_t s_lastCpuNs[Profiler::MAX_THREADS];
+static uint64_t s_lastCollectNs = 0;
+static uint64_t s_lastProcessCpuNs = 0;
+
+const char* Profiler::stageName(int stage) {
+    static const char *names[NUM_STAGES] = {
+        "wait", "convert", "fft", "power", "db", "publish", "render", "replot"
+    };
+    return stage >= 0 && stage < NUM_STAGES ? names[stage] : "?";
+}
+
+uint64_t Profiler::nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t cpuNs(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;   // thread has exited
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+Profiler::ThreadBlock* Profiler::claim(const char *name) {
+    // Stops counting at MAX_THREADS, so refusals can't run it past the table
+    int index = s_claimed.load(std::memory_order_relaxed);
+    do {
+        if (index >= MAX_THREADS) {
+            return nullptr;
+        }
+    } while (!s_claimed.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    // Counters start at zero (static storage); only the header is set here
+    ThreadBlock *block = &s_blocks[index];
+    if (name) {
+        snprintf(block->name, sizeof(block->name), "%s", name);
+    } else {
+        snprintf(block->name, sizeof(block->name), "thread %d", index);
+    }
+    block->hasCpuClock = pthread_getcpuclockid(pthread_self(), &block->cpuClock) == 0;
+    block->active.store(true, std::memory_order_release);
+    return block;
+}
+
+void Profiler::registerThread(const char *name) {
+    if (!t_block) {
+        ThreadBlock *block = claim(name);
+        t_block = block ? (void*)block : &s_notProfiled;
+    }
+}
+
+void Profiler::record(Stage stage, uint64_t ns) {
+    if (!enabled()) {
+        return;
+    }
+    if (!t_block) {
+        ThreadBlock *block = claim(nullptr);
+        t_block = block ? (void*)block : &s_notProfiled;
+    }
+    if (t_block == &s_notProfiled) {
+        return;
+    }
+
+    // Single writer: plain load + store, nothing the reader can block on
+    StageCounters &counters = static_cast<ThreadBlock*>(t_block)->stages[stage];
+    std::atomic<uint32_t> &bucket = counters.buckets[LatencyHistogram::bucketOf(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counters.sumNs.store(counters.sumNs.load(std::memory_order_relaxed) + ns,
+                         std::memory_order_relaxed);
+    if (ns > counters.maxNs.load(std::memory_order_relaxed)) {
+        counters.maxNs.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void Profiler::collect(Snapshot *out) {
+    uint64_t now = nowNs();
+    uint64_t processCpu = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t wall = s_lastCollectNs ? now - s_lastCollectNs : 0;
+
+    *out = Snapshot();
+    out->seconds = wall / 1e9;
+    if (wall > 0) {
+        out->processCpuPercent = 100.0 * (processCpu - s_lastProcessCpuNs) / wall;
+    }
+    s_lastCollectNs = now;
+    s_lastProcessCpuNs = processCpu;
+
+    int claimed = std::min(s_claimed.load(std::memory_order_relaxed), (int)MAX_THREADS);
+    uint64_t counts[LatencyHistogram::BUCKETS];
+    for (int t = 0; t < claimed; t++) {
+        ThreadBlock &block = s_blocks[t];
+        if (!block.active.load(std::memory_order_acquire)) {
+            continue;   // claimed but not set up yet
+        }
+
+        ThreadSnapshot thread;
+        thread.name = block.name;
+        thread.cpuPercent = 0.0;
+        if (block.hasCpuClock) {
+            uint64_t cpu = cpuNs(block.cpuClock);
+            if (wall > 0 && cpu >= s_lastCpuNs[t]) {
+                thread.cpuPercent = 100.0 * (cpu - s_lastCpuNs[t]) / wall;
+            }
+            s_lastCpuNs[t] = cpu;
+        }
+
+        bool recorded = false;
+        for (int s = 0; s < NUM_STAGES; s++) {
+            StageCounters &counters = block.stages[s];
+            // Counters wrap; the difference is right as long as fewer than
+            // 2^32 samples land in a bucket between two collects
+            for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+                uint32_t count = counters.buckets[i].load(std::memory_order_relaxed);
+                counts[i] = (uint32_t)(count - s_lastBuckets[t][s][i]);
+                s_lastBuckets[t][s][i] = count;
+            }
+            uint64_t sum = counters.sumNs.load(std::memory_order_relaxed);
+            uint64_t max = counters.maxNs.exchange(0, std::memory_order_relaxed);
+            thread.stages[s].addBuckets(counts, sum - s_lastSumNs[t][s], max);
+            s_lastSumNs[t][s] = sum;
+
+            out->stages[s].merge(thread.stages[s]);
+            recorded |= thread.stages[s].count() != 0;
+        }
+        if (recorded || thread.cpuPercent >= 0.05) {
+            out->threads.push_back(thread);
+        }
+    }
+}
+
+std::string Profiler::format(const Snapshot &snapshot) {
+    std::string text;
+    char line[96];
+    snprintf(line, sizeof(line), "%-8s %8s %8s %8s %7s", "us", "p50", "p99", "max", "/s");
+    text += line;
+    for (int s = 0; s < NUM_STAGES; s++) {
+        const LatencyHistogram &h = snapshot.stages[s];
+        if (h.count() == 0) {
+            continue;
+        }
+        double rate = snapshot.seconds > 0.0 ? h.count() / snapshot.seconds : 0.0;
+        snprintf(line, sizeof(line), "\n%-8s %8.1f %8.1f %8.1f %7.1f", stageName(s),
+                 h.percentileNs(0.5) / 1e3, h.percentileNs(0.99) / 1e3, h.maxNs() / 1e3, rate);
+        text += line;
+    }
+
+    snprintf(line, sizeof(line), "\nCPU %.0f%%", snapshot.processCpuPercent);
+    text += line;
+    for (const ThreadSnapshot &thread : snapshot.threads) {
+        snprintf(line, sizeof(line), "  %s %.0f%%", thread.name.c_str(), thread.cpuPercent);
+        text += line;
+    }
+    return text;
+}
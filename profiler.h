@@ -0,0 +1,118 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "latencystats.h"
+
+// Built-in profiler: time spent per pipeline stage, per thread.
+//
+// Every thread that records gets one fixed block of counters, claimed once
+// from a static table: per stage, bucket counts in LatencyHistogram's
+// layout plus a sum and a running max. The owning thread is the only
+// writer and updates them with relaxed loads and stores - no locks, no
+// read-modify-write, no allocation - so recording costs a bucket index and
+// a handful of stores. One reader (ProfileMonitor) diffs the blocks against
+// its previous snapshot into per-interval histograms and samples each
+// thread's CPU clock for CPU%. A snapshot taken mid-update can be off by
+// one sample, which doesn't show at this resolution.
+//
+// Off until setEnabled(true); while off, record() returns straight away
+// and ProfileTimer doesn't read the clock.
+class Profiler {
+public:
+    enum Stage {
+        Wait,      // DSP: blocked on the sample source
+        Convert,   // DSP: convert, DC removal and window (one fused pass)
+        FFT,       // DSP: FFT execute
+        Power,     // DSP: |X|^2 into the group's power buffer
+        Db,        // DSP: group power -> dB
+        Publish,   // DSP: handing the spectrum to the bus
+        Render,    // render thread: rasterizing a spectrum image
+        Replot,    // GUI thread: QCustomPlot replot or image blit
+        NUM_STAGES
+    };
+    static const char* stageName(int stage);
+
+    // Threads beyond this many aren't profiled
+    static const int MAX_THREADS = 8;
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on) { s_enabled.store(on, std::memory_order_relaxed); }
+
+    // Names the calling thread's block, claiming one if needed. Threads
+    // that record without registering show up as "thread <n>".
+    static void registerThread(const char *name);
+
+    // The calling thread spent ns in stage
+    static void record(Stage stage, uint64_t ns);
+
+    // CLOCK_MONOTONIC
+    static uint64_t nowNs();
+
+    struct ThreadSnapshot {
+        std::string name;
+        double cpuPercent;   // of one core
+        LatencyHistogram stages[NUM_STAGES];
+    };
+    struct Snapshot {
+        double seconds;            // covered by this snapshot
+        double processCpuPercent;  // all threads, of one core
+        std::vector<ThreadSnapshot> threads;   // those that recorded or burned CPU
+        LatencyHistogram stages[NUM_STAGES];   // all threads merged
+
+        Snapshot() : seconds(0.0), processCpuPercent(0.0) {}
+    };
+
+    // Everything recorded since the previous call (the first call covers
+    // everything so far). One reader thread only.
+    static void collect(Snapshot *out);
+
+    // Per stage p50 / p99 / max in us and calls/s, then CPU% per thread
+    static std::string format(const Snapshot &snapshot);
+
+private:
+    struct StageCounters {
+        std::atomic<uint32_t> buckets[LatencyHistogram::BUCKETS];
+        std::atomic<uint64_t> sumNs;
+        std::atomic<uint64_t> maxNs;   // since the reader last took it
+    };
+    struct ThreadBlock {
+        std::atomic<bool> active;   // set once name and cpuClock are written
+        char name[24];
+        clockid_t cpuClock;
+        bool hasCpuClock;
+        StageCounters stages[NUM_STAGES];
+    };
+
+    static ThreadBlock* claim(const char *name);
+
+    static std::atomic<bool> s_enabled;
+    static std::atomic<int> s_claimed;
+    static ThreadBlock s_blocks[MAX_THREADS];
+};
+
+// Records the time until the end of the scope under stage, if profiling is
+// on when it starts
+class ProfileTimer {
+public:
+    explicit ProfileTimer(Profiler::Stage stage)
+            : m_stage(stage)
+            , m_startNs(Profiler::enabled() ? Profiler::nowNs() : 0)
+    {
+    }
+    ~ProfileTimer() {
+        if (m_startNs) {
+            Profiler::record(m_stage, Profiler::nowNs() - m_startNs);
+        }
+    }
+
+private:
+    Profiler::Stage m_stage;
+    uint64_t m_startNs;
+};
+
+#endif
@@ -4,11 +4,25 @@
 #include <stddef.h>
 #include <rsc_types.h>
 
+/*
+ * Slot-ready interrupt: firmware raises system event 19 (pr1_pru_mst_intr[3])
+ * after publishing each ring slot. Route it to channel 2 / host 2, which is
+ * PRU-ICSS evtout0 on the ARM side (/dev/uio0 with a uio_pdrv_genirq node).
+ */
+#define PRU0_ARM_SYSEVT     19
+#define PRU0_ARM_CHANNEL    2
+#define HOST_UNUSED         255
+
+struct ch_map pru_intc_map[] = {
+    { PRU0_ARM_SYSEVT, PRU0_ARM_CHANNEL },
+};
+
 /* PRU0 Resource Table */
 struct pru0_resource_table {
     struct resource_table base;
-    uint32_t offset[1];
+    uint32_t offset[2];
     struct fw_rsc_carveout shared_ram;
+    struct fw_rsc_custom pru_ints;
 };
 
 /* Place resource table in special section */
@@ -17,20 +31,34 @@ struct pru0_resource_table {
 struct pru0_resource_table resource_table = {
     .base = {
         1,      // version
-        1,      // number of entries
+        2,      // number of entries
         {0, 0}, // reserved
     },
     .offset = {
         offsetof(struct pru0_resource_table, shared_ram),
+        offsetof(struct pru0_resource_table, pru_ints),
     },
     .shared_ram = {
         TYPE_CARVEOUT,
         0,           // device address
         0x00010000,  // physical start of shared RAM
-        0x2000,      // size (8KB for buffers + flags)
+        0x3000,      // size (12KB sample ring, see pru_ring.h)
         0,           // flags
         0,           // reserved
         "PRU_SHARED_RAM"
+    },
+    .pru_ints = {
+        TYPE_POSTLOAD_VENDOR,
+        { TYPE_PRU_INTS },
+        sizeof(struct fw_rsc_custom_ints),
+        { .pru_ints = {
+            0x0000,
+            // channel-to-host map: channel 2 -> host 2
+            { HOST_UNUSED, HOST_UNUSED, 2, HOST_UNUSED, HOST_UNUSED,
+              HOST_UNUSED, HOST_UNUSED, HOST_UNUSED, HOST_UNUSED, HOST_UNUSED },
+            sizeof(pru_intc_map) / sizeof(struct ch_map),
+            pru_intc_map,
+        } },
     }
 };
 
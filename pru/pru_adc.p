@@ -1,6 +1,6 @@
 // ============================================================================
-// PRU ADC Sampler with Ping-Pong Buffers
-// Samples AIN0 at 48 kHz and stores in alternating buffers
+// PRU ADC Sampler with N-slot Sample Ring
+// Samples AIN0 at 48 kHz into the shared RAM ring described in pru_ring.h
 // ============================================================================
 
 .origin 0
@@ -10,23 +10,42 @@
 // Register Assignments
 // ============================================================================
 #define REG_ADC_BASE        r0      // ADC register base address
-#define REG_SAMPLE_COUNT    r1      // Current sample count (0-1023)
+#define REG_SAMPLE_COUNT    r1      // Current sample count in slot (0-1023)
 #define REG_BUFFER_PTR      r2      // Current write pointer
 #define REG_TEMP            r3      // Temporary register for operations
 #define REG_DELAY           r4      // Delay loop counter
 #define REG_ADC_VALUE       r5      // ADC sample value
-#define REG_CURRENT_BUFFER  r6      // Which buffer (1=A, 2=B)
-#define REG_FLAGS_ADDR      r7      // Address of control flags
+#define REG_SLOT_INDEX      r6      // Current slot (write_seq % RING_NUM_SLOTS)
+#define REG_RING_ADDR       r7      // Address of ring header
 #define REG_FIFO_ADDR       r8      // pre-computed FIFO address
+#define REG_WRITE_SEQ       r9      // Slots published so far
+#define REG_READ_SEQ        r10     // Consumer's read_seq (overrun check)
+#define REG_IEP_ADDR        r11     // IEP timer base (capture timestamps)
+#define REG_STAMP           r12     // IEP count at slot completion
 
 // ============================================================================
 // Memory Map
 // ============================================================================
+// Must match pru_ring.h (pasm can't include the C header)
 #define SHARED_RAM_BASE     0x00010000
-#define BUFFER_A_BASE       0x00010000  // First 2KB
-#define BUFFER_B_BASE       0x00010800  // Second 2KB
-#define FLAGS_BASE          0x00011000  // Control flags
-#define BUFFER_SIZE         1024        // Samples per buffer
+#define RING_BASE           0x00010000  // Ring header
+#define SLOT0_BASE          0x00010100  // First slot, right after header
+#define SLOT_BYTES          0x800       // 1024 samples x 2 bytes
+#define RING_NUM_SLOTS      5
+#define RING_MAGIC          0x474E5250  // "PRNG"
+#define RING_GEOMETRY       0x00050002  // num_slots << 16 | version
+#define RING_OFF_MAGIC      0x00
+#define RING_OFF_VERSION    0x04
+#define RING_OFF_SLOT_SIZE  0x08
+#define RING_OFF_WRITE_SEQ  0x10
+#define RING_OFF_READ_SEQ   0x14
+#define RING_OFF_OVERRUNS   0x18
+#define RING_OFF_STAMP_HZ   0x1C
+#define RING_OFF_STAMPS     0x20        // + 4 * slot index
+#define BUFFER_SIZE         1024        // Samples per slot
+
+// Slot-ready interrupt (see resource_table_pru0.h)
+#define PRU0_ARM_INTERRUPT  19          // System event routed to the ARM
 
 // ============================================================================
 // ADC Register Offsets (from TI AM335x TRM)
@@ -39,6 +58,15 @@
 #define ADC_FIFO0DATA       0x100       // FIFO data register
 #define ADC_FIFO0COUNT      0xE4        // FIFO count register
 
+// ============================================================================
+// IEP Timer (PRU local address): free-running 200 MHz counter
+// ============================================================================
+#define IEP_BASE            0x0002E000
+#define IEP_GLOBAL_CFG      0x00
+#define IEP_COMPEN          0x08
+#define IEP_COUNT           0x0C
+#define IEP_HZ              200000000
+
 // ============================================================================
 // Timing Constants
 // ============================================================================
@@ -73,15 +101,38 @@ INIT_DELAY:
     SBBO REG_TEMP, REG_ADC_BASE, ADC_STEPCONFIG1, 4
     SBBO REG_TEMP, REG_ADC_BASE, ADC_STEPDELAY1, 4
 
-    // Initialize buffer management
-    MOV REG_BUFFER_PTR, BUFFER_A_BASE      // Start with Buffer A
+    // Start the IEP counter: increment by 1 per cycle, no compensation
+    MOV REG_IEP_ADDR, IEP_BASE
+    MOV REG_TEMP, 0
+    SBBO REG_TEMP, REG_IEP_ADDR, IEP_GLOBAL_CFG, 4
+    SBBO REG_TEMP, REG_IEP_ADDR, IEP_COMPEN, 4
+    MOV REG_TEMP, 0xFFFFFFFF                // write 1s to clear
+    SBBO REG_TEMP, REG_IEP_ADDR, IEP_COUNT, 4
+    MOV REG_TEMP, 0x11                      // DEFAULT_INC = 1, CNT_ENABLE
+    SBBO REG_TEMP, REG_IEP_ADDR, IEP_GLOBAL_CFG, 4
+
+    // Initialize ring management
+    MOV REG_BUFFER_PTR, SLOT0_BASE          // Start with slot 0
     MOV REG_SAMPLE_COUNT, 0                 // No samples yet
-    MOV REG_CURRENT_BUFFER, 1               // 1 = Buffer A, 2 = Buffer B
-    MOV REG_FLAGS_ADDR, FLAGS_BASE          // Flags address
+    MOV REG_SLOT_INDEX, 0
+    MOV REG_WRITE_SEQ, 0
+    MOV REG_RING_ADDR, RING_BASE            // Ring header address
 
-    // Clear ready flag (0 = no buffer ready)
+    // Initialize ring header, magic last so the ARM never sees a valid
+    // ring with stale counters
     MOV REG_TEMP, 0
-    SBBO REG_TEMP, REG_FLAGS_ADDR, 0, 1
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_MAGIC, 4
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_WRITE_SEQ, 4
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_READ_SEQ, 4
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_OVERRUNS, 4
+    MOV REG_TEMP, RING_GEOMETRY
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_VERSION, 4
+    MOV REG_TEMP, BUFFER_SIZE
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_SLOT_SIZE, 4
+    MOV REG_TEMP, IEP_HZ
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_STAMP_HZ, 4
+    MOV REG_TEMP, RING_MAGIC
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_MAGIC, 4
 
 // ============================================================================
 // Main Sampling Loop
@@ -115,7 +166,7 @@ POLL_FIFO:
     AND REG_ADC_VALUE, REG_ADC_VALUE, REG_TEMP   // Mask to 12 bits
 
     // -------------------------
-    // 4. Store Sample in Current Buffer
+    // 4. Store Sample in Current Slot
     // -------------------------
     SBBO REG_ADC_VALUE, REG_BUFFER_PTR, 0, 2   // Write 2 bytes (16-bit)
 
@@ -126,27 +177,42 @@ POLL_FIFO:
     ADD REG_SAMPLE_COUNT, REG_SAMPLE_COUNT, 1  // Increment counter
 
     // -------------------------
-    // 6. Check if Buffer is Full
+    // 6. Check if Slot is Full
     // -------------------------
-    MOV REG_TEMP, 1024
+    MOV REG_TEMP, BUFFER_SIZE
     QBNE TIMING_DELAY, REG_SAMPLE_COUNT, REG_TEMP
 
-    // Buffer is full! Switch buffers
-    SBBO REG_CURRENT_BUFFER, REG_FLAGS_ADDR, 0, 1  // Set ready flag
-
-    // Swap to other buffer
-    QBEQ SWITCH_TO_B, REG_CURRENT_BUFFER, 1
-
-SWITCH_TO_A:
-    MOV REG_CURRENT_BUFFER, 1
-    MOV REG_BUFFER_PTR, BUFFER_A_BASE
-    JMP BUFFER_SWITCHED
-
-SWITCH_TO_B:
-    MOV REG_CURRENT_BUFFER, 2
-    MOV REG_BUFFER_PTR, BUFFER_B_BASE
-
-BUFFER_SWITCHED:
+    // Slot is full! Stamp it with the IEP count, then publish it by
+    // bumping write_seq (samples already stored)
+    LBBO REG_STAMP, REG_IEP_ADDR, IEP_COUNT, 4
+    LSL REG_TEMP, REG_SLOT_INDEX, 2
+    ADD REG_TEMP, REG_TEMP, RING_OFF_STAMPS
+    SBBO REG_STAMP, REG_RING_ADDR, REG_TEMP, 4
+    ADD REG_WRITE_SEQ, REG_WRITE_SEQ, 1
+    SBBO REG_WRITE_SEQ, REG_RING_ADDR, RING_OFF_WRITE_SEQ, 4
+
+    // Overrun if consumer is a whole ring behind (next slot still unread)
+    LBBO REG_READ_SEQ, REG_RING_ADDR, RING_OFF_READ_SEQ, 4
+    SUB REG_TEMP, REG_WRITE_SEQ, REG_READ_SEQ
+    QBGT NO_OVERRUN, REG_TEMP, RING_NUM_SLOTS  // Branch if (write - read) < N
+    LBBO REG_TEMP, REG_RING_ADDR, RING_OFF_OVERRUNS, 4
+    ADD REG_TEMP, REG_TEMP, 1
+    SBBO REG_TEMP, REG_RING_ADDR, RING_OFF_OVERRUNS, 4
+
+NO_OVERRUN:
+    // Wake the ARM side instead of making it poll write_seq
+    MOV R31.b0, PRU0_ARM_INTERRUPT+16
+
+    // Advance to next slot, wrapping back to slot 0
+    ADD REG_SLOT_INDEX, REG_SLOT_INDEX, 1
+    QBEQ WRAP_RING, REG_SLOT_INDEX, RING_NUM_SLOTS
+    JMP SLOT_SWITCHED                          // REG_BUFFER_PTR already at next slot
+
+WRAP_RING:
+    MOV REG_SLOT_INDEX, 0
+    MOV REG_BUFFER_PTR, SLOT0_BASE
+
+SLOT_SWITCHED:
     MOV REG_SAMPLE_COUNT, 0                    // Reset counter
 
     // -------------------------
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include "pru_cfg.h"
 #include "resource_table_pru0.h"  // required for remoteproc
+#include "pru_ring.h"
 
 volatile register uint32_t __R30;
 volatile register uint32_t __R31;
@@ -9,11 +10,10 @@ volatile register uint32_t __R31;
 // Memory map
 // ---------------------------------------------------------------------------
 #define SHARED_RAM_BASE 0x00010000
-#define BUFFER_A_BASE   ((volatile uint16_t *)(SHARED_RAM_BASE + 0x0000))
-#define BUFFER_B_BASE   ((volatile uint16_t *)(SHARED_RAM_BASE + 0x0800))
-#define FLAGS_BASE      ((volatile uint8_t *)(SHARED_RAM_BASE + 0x1000))
+#define RING            ((volatile struct pru_ring_header *)(SHARED_RAM_BASE + PRU_RING_HEADER_OFFSET))
+#define SLOT0_BASE      ((volatile uint16_t *)(SHARED_RAM_BASE + PRU_RING_SLOTS_OFFSET))
 
-#define BUFFER_SIZE     1024
+#define BUFFER_SIZE     PRU_RING_SLOT_SAMPLES
 
 // ---------------------------------------------------------------------------
 // ADC Registers (AM335x TRM)
@@ -26,6 +26,14 @@ volatile register uint32_t __R31;
 #define ADC_STEPCONFIG1 (*(volatile uint32_t *)(ADC_BASE + 0x64))
 #define ADC_STEPDELAY1  (*(volatile uint32_t *)(ADC_BASE + 0x68))
 
+// ---------------------------------------------------------------------------
+// IEP timer: free-running 200 MHz counter for the slot capture timestamps
+// ---------------------------------------------------------------------------
+#define IEP_BASE        0x0002E000
+#define IEP_GLOBAL_CFG  (*(volatile uint32_t *)(IEP_BASE + 0x00))
+#define IEP_COMPEN      (*(volatile uint32_t *)(IEP_BASE + 0x08))
+#define IEP_COUNT       (*(volatile uint32_t *)(IEP_BASE + PRU_IEP_OFF_COUNT))
+
 // ---------------------------------------------------------------------------
 // Timing
 // ---------------------------------------------------------------------------
@@ -39,6 +47,13 @@ volatile register uint32_t __R31;
 // New total: 1343 + 655 = 1998
 #define SAMPLE_DELAY_CYCLES 1998
 
+// ---------------------------------------------------------------------------
+// Host interrupt: writing (1 << 5) | (event - 16) to R31 raises a system
+// event. PRU0_ARM_SYSEVT is routed to the ARM in the resource table.
+// ---------------------------------------------------------------------------
+#define R31_INTERRUPT_ENABLE (1 << 5)
+#define R31_EVENT_MASK       0x0F
+
 // ---------------------------------------------------------------------------
 // Delay helper - external assembly function for deterministic timing
 // Implemented in delay.asm: 2 cycles per iteration (SUB + QBNE)
@@ -50,9 +65,10 @@ extern void delay_cycles(uint32_t cycles);
 // ---------------------------------------------------------------------------
 void main(void)
 {
-    volatile uint16_t *buffer_ptr = BUFFER_A_BASE;
+    volatile uint16_t *buffer_ptr = SLOT0_BASE;
     uint16_t sample_count = 0;
-    uint8_t current_buffer = 1;  // 1=A, 2=B
+    uint16_t slot_index = 0;     // write_seq % PRU_RING_NUM_SLOTS, kept separately (no divider)
+    uint32_t write_seq = 0;
 
     // Initialize ADC
     ADC_CTRL = 0x07;           // Enable ADC module
@@ -60,8 +76,23 @@ void main(void)
     ADC_STEPCONFIG1 = 0x0;     // AIN0, one-shot
     ADC_STEPDELAY1  = 0x0;
 
-    // Clear buffer ready flag
-    FLAGS_BASE[0] = 0;
+    // Start the IEP counter: increment by 1 per cycle, no compensation
+    IEP_GLOBAL_CFG = 0;
+    IEP_COUNT = 0xFFFFFFFF;    // write 1s to clear
+    IEP_COMPEN = 0;
+    IEP_GLOBAL_CFG = 0x11;     // DEFAULT_INC = 1, CNT_ENABLE
+
+    // Initialize ring header. magic goes last so the ARM side never sees
+    // a valid ring with stale counters.
+    RING->magic = 0;
+    RING->version = PRU_RING_VERSION;
+    RING->num_slots = PRU_RING_NUM_SLOTS;
+    RING->slot_samples = PRU_RING_SLOT_SAMPLES;
+    RING->write_seq = 0;
+    RING->read_seq = 0;
+    RING->overrun_count = 0;
+    RING->stamp_hz = PRU_IEP_HZ;
+    RING->magic = PRU_RING_MAGIC;
 
     while(1) {
         // Trigger step 1
@@ -73,21 +104,31 @@ void main(void)
         // Read sample
         uint16_t sample = (uint16_t)(ADC_FIFO0DATA & 0x0FFF);
 
-        // Store in buffer
+        // Store in current slot
         buffer_ptr[sample_count++] = sample;
 
-        // Check if buffer full
+        // Check if slot full
         if(sample_count >= BUFFER_SIZE) {
-            // Set ready flag
-            FLAGS_BASE[0] = current_buffer;
+            // Publish slot: samples are already stored, stamp it and bump
+            // the sequence
+            RING->slot_stamp[slot_index] = IEP_COUNT;
+            write_seq++;
+            RING->write_seq = write_seq;
+
+            // Consumer a full ring behind means the next slot is still unread
+            if((write_seq - RING->read_seq) >= PRU_RING_NUM_SLOTS) {
+                RING->overrun_count++;
+            }
+
+            // Wake the ARM side instead of making it poll write_seq
+            __R31 = R31_INTERRUPT_ENABLE | ((PRU0_ARM_SYSEVT - 16) & R31_EVENT_MASK);
 
-            // Swap buffer
-            if(current_buffer == 1) {
-                current_buffer = 2;
-                buffer_ptr = BUFFER_B_BASE;
+            // Advance to next slot
+            if(++slot_index >= PRU_RING_NUM_SLOTS) {
+                slot_index = 0;
+                buffer_ptr = SLOT0_BASE;
             } else {
-                current_buffer = 1;
-                buffer_ptr = BUFFER_A_BASE;
+                buffer_ptr += BUFFER_SIZE;
             }
             sample_count = 0;
         }
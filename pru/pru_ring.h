@@ -0,0 +1,83 @@
+#ifndef PRU_RING_H
+#define PRU_RING_H
+
+// ---------------------------------------------------------------------------
+// PRU shared RAM sample ring
+//
+// Single-producer (PRU) / single-consumer (ARM) ring of fixed-size sample
+// slots filling the 12KB shared RAM window. Shared between the PRU firmware,
+// the ARM-side helper programs and DSPThread, so keep it plain C.
+//
+// Layout (offsets from the start of PRU shared RAM, 0x4A310000 on the ARM):
+//   0x0000  ring header (magic, geometry, sequence counters)
+//   0x0100  slot 0 (1024 x uint16_t)
+//   0x0900  slot 1
+//   ...
+//   0x2100  slot 4      (ends at 0x2900, inside PRU_MEM_SIZE = 0x3000)
+//
+// write_seq counts slots the producer has completed and read_seq counts
+// slots the consumer has finished with. Both only ever increase (mod 2^32),
+// so write_seq - read_seq is exactly how many slots the consumer is behind.
+// Slot for sequence number s is s % PRU_RING_NUM_SLOTS. The producer fills
+// slot write_seq % N and publishes it by incrementing write_seq after the
+// last sample store; if that leaves the consumer N or more slots behind,
+// the oldest unread slot has been overwritten and overrun_count goes up.
+//
+// Capture timestamps (version 2): right before publishing slot s the
+// producer stores its free-running 32-bit clock in slot_stamp[s % N] - the
+// PRU IEP counter (200 MHz, wraps every ~21 s) on the firmware, CLOCK_MONOTONIC
+// in microseconds on the simulators. stamp_hz is that clock's rate, 0 if the
+// producer doesn't stamp. The ARM side correlates the counter with
+// CLOCK_MONOTONIC by reading the same clock itself (see CaptureClock).
+// ---------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#define PRU_RING_MAGIC          0x474E5250u   // "PRNG"
+#define PRU_RING_VERSION        2     // 2: capture timestamps
+
+#define PRU_RING_HEADER_OFFSET  0x0000
+#define PRU_RING_HEADER_SIZE    0x0100
+#define PRU_RING_SLOT_SAMPLES   1024
+#define PRU_RING_SLOT_BYTES     (PRU_RING_SLOT_SAMPLES * 2)
+#define PRU_RING_NUM_SLOTS      5
+#define PRU_RING_SLOTS_OFFSET   PRU_RING_HEADER_SIZE
+#define PRU_RING_TOTAL_SIZE     (PRU_RING_SLOTS_OFFSET + PRU_RING_NUM_SLOTS * PRU_RING_SLOT_BYTES)
+
+// Header field offsets (for the assembly firmware, which can't use the struct)
+#define PRU_RING_OFF_MAGIC      0x00
+#define PRU_RING_OFF_VERSION    0x04
+#define PRU_RING_OFF_NUM_SLOTS  0x06
+#define PRU_RING_OFF_SLOT_SIZE  0x08
+#define PRU_RING_OFF_WRITE_SEQ  0x10
+#define PRU_RING_OFF_READ_SEQ   0x14
+#define PRU_RING_OFF_OVERRUNS   0x18
+#define PRU_RING_OFF_STAMP_HZ   0x1C
+#define PRU_RING_OFF_STAMPS     0x20   // + 4 * (seq % PRU_RING_NUM_SLOTS)
+
+// PRU-ICSS IEP timer, the firmware's timestamp clock
+#define PRU_IEP_HZ              200000000u
+#define PRU_IEP_ARM_ADDRESS     0x4A32E000u   // as the ARM sees it
+#define PRU_IEP_OFF_COUNT       0x0C
+
+struct pru_ring_header {
+    uint32_t magic;          // PRU_RING_MAGIC once the producer has initialized
+    uint16_t version;        // PRU_RING_VERSION
+    uint16_t num_slots;      // PRU_RING_NUM_SLOTS
+    uint16_t slot_samples;   // PRU_RING_SLOT_SAMPLES
+    uint16_t reserved0;
+    uint32_t reserved1;
+    uint32_t write_seq;      // written by producer only
+    uint32_t read_seq;       // written by consumer only
+    uint32_t overrun_count;  // written by producer only
+    uint32_t stamp_hz;       // slot_stamp clock rate, 0 = no timestamps
+    uint32_t slot_stamp[PRU_RING_NUM_SLOTS];   // clock when slot s % N was completed
+};
+
+static inline volatile uint16_t *pru_ring_slot(volatile void *base, uint32_t seq)
+{
+    return (volatile uint16_t *)((volatile uint8_t *)base + PRU_RING_SLOTS_OFFSET +
+                                 (seq % PRU_RING_NUM_SLOTS) * PRU_RING_SLOT_BYTES);
+}
+
+#endif /* PRU_RING_H */
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <math.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "pru/pru_ring.h"
+
+// Stand-in for the PRU firmware on a machine without one: fills a
+// /dev/shm file laid out like PRU shared RAM at 48 kHz, so the analyzer can
+// run with --source shm[:name]. Each publish is followed by a FUTEX_WAKE on
+// write_seq so the analyzer sleeps until data lands instead of polling.
+//
+// Build: gcc -O2 -o pru_sim pru_sim.c -lm
+// Usage: pru_sim [name] [freq_hz] [amplitude_vpk] [noise_vrms]
+
+#define PRU_MEM_SIZE 0x3000
+#define SAMPLE_RATE 48000
+#define BUFFER_SIZE PRU_RING_SLOT_SAMPLES
+
+volatile int keep_running = 1;
+
+void signal_handler(int signum) {
+    keep_running = 0;
+}
+
+// Box-Muller, good enough for a test signal
+static double gaussian(void) {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = argc > 1 ? argv[1] : "pru_ring";
+    double freq = argc > 2 ? atof(argv[2]) : 1000.0;
+    double amplitude = argc > 3 ? atof(argv[3]) : 0.3;
+    double noise = argc > 4 ? atof(argv[4]) : 0.0;
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/dev/shm/", name);
+
+    printf("Simulated PRU ADC Sampler (48 kHz)\n");
+    printf("==================================\n\n");
+
+    signal(SIGINT, signal_handler);
+
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        perror("Cannot open shared memory file");
+        return 1;
+    }
+    if (ftruncate(fd, PRU_MEM_SIZE) < 0) {
+        perror("Cannot size shared memory file");
+        close(fd);
+        return 1;
+    }
+
+    void *shared_map = mmap(0, PRU_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (shared_map == MAP_FAILED) {
+        perror("Cannot map shared memory file");
+        close(fd);
+        return 1;
+    }
+
+    volatile struct pru_ring_header *ring =
+        (volatile struct pru_ring_header *)((char*)shared_map + PRU_RING_HEADER_OFFSET);
+
+    // Initialize ring header, magic last (same as the firmware)
+    ring->magic = 0;
+    ring->version = PRU_RING_VERSION;
+    ring->num_slots = PRU_RING_NUM_SLOTS;
+    ring->slot_samples = PRU_RING_SLOT_SAMPLES;
+    ring->write_seq = 0;
+    ring->read_seq = 0;
+    ring->overrun_count = 0;
+    ring->stamp_hz = 1000000;   // CLOCK_MONOTONIC microseconds
+    __sync_synchronize();
+    ring->magic = PRU_RING_MAGIC;
+
+    printf("Ring: %s (%d slots x %d samples)\n", path, PRU_RING_NUM_SLOTS, PRU_RING_SLOT_SAMPLES);
+    printf("Signal: %.1f Hz @ %.3f Vpk, noise %.4f Vrms, 0.9V bias\n", freq, amplitude, noise);
+    printf("Press Ctrl+C to stop\n\n");
+
+    uint32_t write_seq = 0;
+    double phase = 0.0;
+    const double phase_step = 2.0 * M_PI * freq / SAMPLE_RATE;
+    const long slot_ns = (long)((double)BUFFER_SIZE * 1000000000.0 / SAMPLE_RATE);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    while (keep_running) {
+        // Sleep until this slot's worth of samples would have been captured
+        deadline.tv_nsec += slot_ns;
+        while (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+
+        volatile uint16_t *slot = pru_ring_slot(shared_map, write_seq);
+        for (int i = 0; i < BUFFER_SIZE; i++) {
+            double volts = 0.9 + amplitude * sin(phase) + (noise > 0.0 ? noise * gaussian() : 0.0);
+            int code = (int)(volts / 1.8 * 4095.0 + 0.5);
+            if (code < 0) code = 0;
+            if (code > 4095) code = 4095;
+            slot[i] = (uint16_t)code;
+
+            phase += phase_step;
+            if (phase >= 2.0 * M_PI) phase -= 2.0 * M_PI;
+        }
+
+        // Stamp and publish slot
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ring->slot_stamp[write_seq % PRU_RING_NUM_SLOTS] =
+            (uint32_t)((uint64_t)now.tv_sec * 1000000u + now.tv_nsec / 1000);
+        __sync_synchronize();
+        ring->write_seq = ++write_seq;
+        if (write_seq - ring->read_seq >= PRU_RING_NUM_SLOTS) {
+            ring->overrun_count++;
+        }
+        syscall(SYS_futex, &ring->write_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+        if (write_seq % 470 == 0) {  // ~10 seconds
+            printf("Slots: %u | Lag: %u Overruns: %u\n",
+                   write_seq, write_seq - ring->read_seq, ring->overrun_count);
+        }
+    }
+
+    printf("\nStopping...\n");
+    munmap(shared_map, PRU_MEM_SIZE);
+    close(fd);
+
+    printf("Done. Published %u slots.\n", write_seq);
+    return 0;
+}
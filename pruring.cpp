@@ -0,0 +1,111 @@
+#include "pruring.h"
+#include <atomic>
+
+PRURingReader::PRURingReader()
+        : m_base(nullptr)
+        , m_header(nullptr)
+        , m_readSeq(0)
+        , m_droppedSlots(0)
+        , m_tornSlots(0)
+{
+}
+
+void PRURingReader::attach(void *base) {
+    m_base = base;
+    m_header = (volatile pru_ring_header*)((volatile uint8_t*)base + PRU_RING_HEADER_OFFSET);
+    m_droppedSlots = 0;
+    m_tornSlots = 0;
+
+    // Start at whatever the producer has already published; older slots
+    // are from before we attached and not worth processing
+    m_readSeq = isReady() ? m_header->write_seq : 0;
+    publishReadSeq();
+}
+
+void PRURingReader::detach() {
+    m_base = nullptr;
+    m_header = nullptr;
+}
+
+bool PRURingReader::isReady() const {
+    return m_header && m_header->magic == PRU_RING_MAGIC &&
+           m_header->num_slots == PRU_RING_NUM_SLOTS &&
+           m_header->slot_samples == PRU_RING_SLOT_SAMPLES;
+}
+
+uint32_t PRURingReader::writeSeq() const {
+    return m_header ? m_header->write_seq : 0;
+}
+
+uint32_t PRURingReader::overrunCount() const {
+    return m_header ? m_header->overrun_count : 0;
+}
+
+uint32_t PRURingReader::stampHz() const {
+    if (!isReady() || m_header->version < 2)
+        return 0;
+    return m_header->stamp_hz;
+}
+
+uint32_t PRURingReader::slotStamp() const {
+    return m_header ? m_header->slot_stamp[m_readSeq % PRU_RING_NUM_SLOTS] : 0;
+}
+
+uint32_t PRURingReader::pending() const {
+    if (!isReady())
+        return 0;
+    return m_header->write_seq - m_readSeq;
+}
+
+const volatile uint16_t* PRURingReader::peek() {
+    if (!isReady())
+        return nullptr;
+
+    uint32_t writeSeq = m_header->write_seq;
+    // Don't let slot reads get ahead of the write_seq load
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    uint32_t lag = writeSeq - m_readSeq;
+    if (lag == 0)
+        return nullptr;
+
+    // write_seq went backwards: the producer restarted and reset the ring
+    if (lag > 0x80000000u) {
+        m_readSeq = writeSeq;
+        publishReadSeq();
+        return nullptr;
+    }
+
+    // Producer is filling slot writeSeq % N, so only the newest N-1
+    // published slots are still intact
+    if (lag > PRU_RING_NUM_SLOTS - 1) {
+        uint32_t skip = lag - (PRU_RING_NUM_SLOTS - 1);
+        m_readSeq += skip;
+        m_droppedSlots += skip;
+        publishReadSeq();
+    }
+
+    return pru_ring_slot(m_base, m_readSeq);
+}
+
+bool PRURingReader::release() {
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // If the producer reached our slot while we were reading it, it has
+    // started overwriting it
+    bool intact = (m_header->write_seq - m_readSeq) < PRU_RING_NUM_SLOTS;
+    if (!intact)
+        m_tornSlots++;
+
+    m_readSeq++;
+    publishReadSeq();
+    return intact;
+}
+
+
+void PRURingReader::publishReadSeq() {
+    if (!m_header)
+        return;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->read_seq = m_readSeq;
+}
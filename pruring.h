@@ -0,0 +1,56 @@
+#ifndef PRURING_H
+#define PRURING_H
+
+#include <cstdint>
+#include "pru/pru_ring.h"
+
+// Consumer side of the PRU shared RAM sample ring (see pru/pru_ring.h).
+// Wraps a mapping of the 12KB shared RAM window; does not own it.
+class PRURingReader {
+public:
+    PRURingReader();
+
+    void attach(void *base);
+    void detach();
+
+    // True once the producer has initialized the header
+    bool isReady() const;
+
+    // Slots published but not yet consumed (write_seq - read_seq)
+    uint32_t pending() const;
+
+    // Next unread slot, or nullptr if the consumer has caught up. If the
+    // producer lapped us, the overwritten slots are skipped and counted in
+    // droppedSlots(). Valid until release().
+    const volatile uint16_t* peek();
+
+    // Done with the slot returned by peek(). Returns false if the producer
+    // wrapped onto it while it was being read (contents are torn).
+    bool release();
+
+    // Capture timestamps (ring version 2): the producer's clock rate, 0 if
+    // it doesn't stamp, and the stamp of the slot peek() returned
+    uint32_t stampHz() const;
+    uint32_t slotStamp() const;
+
+    uint32_t writeSeq() const;
+    const volatile uint32_t* writeSeqAddress() const { return m_header ? &m_header->write_seq : nullptr; }
+    uint32_t readSeq() const { return m_readSeq; }
+    uint32_t overrunCount() const;
+    uint64_t droppedSlots() const { return m_droppedSlots; }
+    uint64_t tornSlots() const { return m_tornSlots; }
+
+    static int slotSamples() { return PRU_RING_SLOT_SAMPLES; }
+    static int numSlots() { return PRU_RING_NUM_SLOTS; }
+
+private:
+    void publishReadSeq();
+
+    volatile void *m_base;
+    volatile pru_ring_header *m_header;
+    uint32_t m_readSeq;
+    uint64_t m_droppedSlots;
+    uint64_t m_tornSlots;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "refreshscheduler.h"
+#include <algorithm>
+#include <cmath>
+
+RefreshScheduler::RefreshScheduler(double maxFps, double idleFps, double idleThresholdDb)
+        : m_minIntervalNs(0)
+        , m_idleIntervalNs(0)
+        , m_idleThresholdDb(idleThresholdDb)
+        , m_haveDrawn(false)
+        , m_idle(false)
+        , m_lastDrawNs(0)
+        , m_lastSequence(0)
+{
+    setMaxFps(maxFps);
+    setIdleFps(idleFps);
+}
+
+void RefreshScheduler::setMaxFps(double fps) {
+    m_minIntervalNs = fps > 0.0 ? (uint64_t)(1e9 / fps) : 0;
+}
+
+void RefreshScheduler::setIdleFps(double fps) {
+    m_idleIntervalNs = fps > 0.0 ? (uint64_t)(1e9 / fps) : 0;
+}
+
+void RefreshScheduler::invalidate() {
+    m_haveDrawn = false;
+    m_lastAxis.reset();
+}
+
+uint64_t RefreshScheduler::drawTime(const SpectrumData &frame) {
+    if (!m_haveDrawn) {
+        m_idle = false;
+        return 0;
+    }
+    if (frame.sequence == m_lastSequence) {
+        return NEVER;
+    }
+
+    m_idle = false;
+    if (frame.axis == m_lastAxis && m_idleThresholdDb > 0.0) {
+        double change = 0.0;
+        const double *db = frame.magnitudes;
+        const double *last = m_lastMagnitudes.data();
+        for (int i = 0; i < frame.numBins; i++) {
+            change = std::max(change, std::fabs(db[i] - last[i]));
+        }
+        m_idle = change < m_idleThresholdDb;
+    }
+
+    return m_lastDrawNs + std::max(m_minIntervalNs, m_idle ? m_idleIntervalNs : 0);
+}
+
+void RefreshScheduler::drawn(const SpectrumData &frame, uint64_t nowNs) {
+    m_haveDrawn = true;
+    m_lastDrawNs = nowNs;
+    m_lastSequence = frame.sequence;
+    m_lastAxis = frame.axis;
+    m_lastMagnitudes.assign(frame.magnitudes, frame.magnitudes + frame.numBins);
+}
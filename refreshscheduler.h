@@ -0,0 +1,57 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <cstdint>
+#include <vector>
+#include "spectrumdata.h"
+
+// Decides when a new spectrum is worth drawing. Drawing is driven by frame
+// arrival rather than a fixed timer:
+//
+//   - a frame whose sequence was already drawn is never drawn again
+//   - draws are at least 1/maxFps apart
+//   - a frame that differs from the last drawn one by less than the idle
+//     threshold (max |dB difference| over all bins) waits until 1/idleFps
+//     after the last draw, so a steady spectrum costs a few redraws a
+//     second instead of the full rate
+//
+// The caller keeps the newest undrawn frame, asks drawTime() when one
+// arrives, draws it once that time is reached (re-asking if a newer one
+// comes first) and reports it with drawn(). Times are any monotonic ns
+// clock, used consistently. Single threaded.
+class RefreshScheduler {
+public:
+    RefreshScheduler(double maxFps = 30.0, double idleFps = 2.0, double idleThresholdDb = 1.0);
+
+    void setMaxFps(double fps);
+    void setIdleFps(double fps);
+    void setIdleThreshold(double db) { m_idleThresholdDb = db; }
+
+    // When `frame` may be drawn: a time at or before now means now,
+    // NEVER means don't
+    uint64_t drawTime(const SpectrumData &frame);
+    void drawn(const SpectrumData &frame, uint64_t nowNs);
+
+    // Forces the next frame through at the normal rate (new background,
+    // cleared display, ...)
+    void invalidate();
+
+    // Whether the last frame passed to drawTime() counted as unchanged
+    bool idle() const { return m_idle; }
+
+    static const uint64_t NEVER = UINT64_MAX;
+
+private:
+    uint64_t m_minIntervalNs;
+    uint64_t m_idleIntervalNs;
+    double m_idleThresholdDb;
+
+    bool m_haveDrawn;
+    bool m_idle;
+    uint64_t m_lastDrawNs;
+    uint64_t m_lastSequence;
+    FrequencyAxisPtr m_lastAxis;
+    std::vector<double> m_lastMagnitudes;   // resized only on FFT size change
+};
+
+#endif
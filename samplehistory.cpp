@@ -0,0 +1,50 @@
+#include "samplehistory.h"
+#include <cstring>
+
+SampleHistory::SampleHistory()
+        : m_buffer(nullptr)
+        , m_capacity(0)
+        , m_written(0)
+        , m_discontinuity(0)
+{
+}
+
+SampleHistory::~SampleHistory() {
+    delete[] m_buffer;
+}
+
+void SampleHistory::reset(int minCapacity) {
+    int capacity = 1;
+    while (capacity < minCapacity) {
+        capacity <<= 1;
+    }
+
+    if (capacity != m_capacity) {
+        delete[] m_buffer;
+        m_buffer = new uint16_t[2 * capacity];
+        m_capacity = capacity;
+    }
+    m_written = 0;
+    m_discontinuity = 0;
+}
+
+void SampleHistory::append(const uint16_t *samples, int count) {
+    // Anything beyond one capacity would be overwritten straight away
+    if (count > m_capacity) {
+        samples += count - m_capacity;
+        m_written += count - m_capacity;
+        count = m_capacity;
+    }
+
+    int pos = (int)(m_written & (m_capacity - 1));
+    int first = count < m_capacity - pos ? count : m_capacity - pos;
+
+    // Primary copy plus mirror
+    memcpy(m_buffer + pos, samples, first * sizeof(uint16_t));
+    memcpy(m_buffer + pos + m_capacity, samples, first * sizeof(uint16_t));
+    if (count > first) {
+        memcpy(m_buffer, samples + first, (count - first) * sizeof(uint16_t));
+        memcpy(m_buffer + m_capacity, samples + first, (count - first) * sizeof(uint16_t));
+    }
+    m_written += count;
+}
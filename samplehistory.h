@@ -0,0 +1,50 @@
+#ifndef SAMPLEHISTORY_H
+#define SAMPLEHISTORY_H
+
+#include <cstdint>
+
+// Continuous history of raw ADC codes stitched together from source blocks,
+// so frames of any length can start at any sample regardless of the PRU's
+// 1024-sample slots.
+//
+// Positions are absolute sample indices since reset(). The buffer is
+// mirrored (every sample is stored at i and i + capacity), so any frame
+// that is still in the history is one contiguous run of memory and the
+// DSP kernels never see a wrap.
+class SampleHistory {
+public:
+    SampleHistory();
+    ~SampleHistory();
+
+    // Drop everything; capacity becomes the next power of two >= minCapacity
+    void reset(int minCapacity);
+
+    void append(const uint16_t *samples, int count);
+
+    // Samples after this position are not contiguous with earlier ones
+    // (the source dropped blocks); frames must not span it
+    void markDiscontinuity() { m_discontinuity = m_written; }
+
+    uint64_t written() const { return m_written; }
+    uint64_t oldest() const { return m_written > (uint64_t)m_capacity ? m_written - m_capacity : 0; }
+    uint64_t discontinuity() const { return m_discontinuity; }
+    int capacity() const { return m_capacity; }
+
+    // [start, start + count) fully written and not yet overwritten
+    bool contains(uint64_t start, int count) const {
+        return start >= oldest() && start + count <= m_written;
+    }
+
+    // Contiguous view of [start, start + count); only valid if contains()
+    const uint16_t* data(uint64_t start) const {
+        return m_buffer + (start & (m_capacity - 1));
+    }
+
+private:
+    uint16_t *m_buffer;    // 2 * m_capacity samples
+    int m_capacity;
+    uint64_t m_written;
+    uint64_t m_discontinuity;
+};
+
+#endif
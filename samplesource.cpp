@@ -0,0 +1,782 @@
+#include "samplesource.h"
+#include <QMap>
+#include <QStringList>
+#include <QDebug>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PRU_SHARED_MEM 0x4A310000  // PRU shared memory address
+#define PRU_MEM_SIZE 0x3000        // 12KB
+#define PRU_IEP_MAP_SIZE 0x1000
+
+#define ADC_FULL_SCALE_CODE 4095
+#define ADC_FULL_SCALE_VOLTS 1.8
+
+static uint16_t voltsToCode(double volts) {
+    double code = volts / ADC_FULL_SCALE_VOLTS * ADC_FULL_SCALE_CODE + 0.5;
+    if (std::isnan(code)) return (ADC_FULL_SCALE_CODE + 1) / 2;   // float WAVs can hold NaN
+    if (code < 0.0) return 0;
+    if (code > ADC_FULL_SCALE_CODE) return ADC_FULL_SCALE_CODE;
+    return (uint16_t)code;
+}
+
+// "a=1,b=2" -> {a: 1, b: 2}
+static QMap<QString, QString> parseOptions(const QString &text) {
+    QMap<QString, QString> options;
+    for (const QString &item : text.split(',')) {
+        if (item.isEmpty())
+            continue;
+        int eq = item.indexOf('=');
+        if (eq < 0)
+            options.insert(item.trimmed(), QString("1"));
+        else
+            options.insert(item.left(eq).trimmed(), item.mid(eq + 1).trimmed());
+    }
+    return options;
+}
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static SignalGeneratorSource* createGenerator(const QMap<QString, QString> &options) {
+    SignalGeneratorSource *gen = new SignalGeneratorSource(
+                options.value("rate", "48000").toInt(),
+                options.value("block", "1024").toInt(),
+                options.value("realtime", "1").toInt() != 0);
+    for (const QString &tone : options.value("tone", "10000:0.3").split('+')) {
+        if (tone.isEmpty())
+            continue;
+        gen->addTone(tone.section(':', 0, 0).toDouble(),
+                     tone.contains(':') ? tone.section(':', 1, 1).toDouble() : 0.3);
+    }
+    gen->setNoise(options.value("noise", "0").toDouble());
+    gen->setPinkNoise(options.value("pink", "0").toDouble());
+    gen->setDC(options.value("dc", "0.9").toDouble());
+    if (options.contains("step")) {
+        QString step = options.value("step");
+        gen->setDCStep((uint64_t)(step.section(':', 0, 0).toDouble() * gen->sampleRate()),
+                       step.section(':', 1, 1).toDouble());
+    }
+    if (options.contains("duration")) {
+        gen->setLength((uint64_t)(options.value("duration").toDouble() * gen->sampleRate()));
+    }
+    if (options.contains("seed"))
+        gen->setSeed(options.value("seed").toUInt());
+    return gen;
+}
+
+SampleSource* SampleSource::create(const QString &spec, QString *error) {
+    QString kind = spec.section(':', 0, 0);
+    QString args = spec.section(':', 1);
+
+    if (kind == "pru") {
+        QMap<QString, QString> options = parseOptions(args);
+        return new PRUSampleSource(options.contains("poll") ? QString()
+                                                           : options.value("uio", "/dev/uio0"));
+    }
+    if (kind == "shm") {
+        return new ShmSampleSource(args.isEmpty() ? QString("pru_ring") : args);
+    }
+    if (kind == "file") {
+        QString path = args.section(',', 0, 0);
+        QMap<QString, QString> options = parseOptions(args.section(',', 1));
+        if (path.isEmpty()) {
+            if (error) *error = "file source needs a path";
+            return nullptr;
+        }
+        return new FileSampleSource(path,
+                                    options.value("rate", "48000").toInt(),
+                                    options.value("block", "1024").toInt(),
+                                    options.value("loop", "1").toInt() != 0,
+                                    options.value("realtime", "1").toInt() != 0);
+    }
+    if (kind == "gen") {
+        return createGenerator(parseOptions(args));
+    }
+    if (kind == "sim") {
+        // The ring has fixed-size slots and the producer must run in real time
+        QMap<QString, QString> options = parseOptions(args);
+        options.insert("block", QString::number(PRU_RING_SLOT_SAMPLES));
+        options.insert("realtime", "1");
+        return new SimulatedPRUSource(createGenerator(options));
+    }
+
+    if (error) *error = QString("unknown sample source '%1'").arg(spec);
+    return nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// SharedRingSource
+// ---------------------------------------------------------------------------
+SharedRingSource::SharedRingSource()
+        : m_waiter(new PollWaiter)
+        , m_map(nullptr)
+        , m_fd(-1)
+        , m_ownsWaiter(true)
+        , m_missedWakeups(0)
+        , m_captureHz(0)
+{
+}
+
+SharedRingSource::~SharedRingSource() {
+    SharedRingSource::close();
+    if (m_ownsWaiter) {
+        delete m_waiter;
+    }
+}
+
+void SharedRingSource::setWaiter(BufferWaiter *waiter, bool owned) {
+    if (m_ownsWaiter) {
+        delete m_waiter;
+    }
+    m_waiter = waiter;
+    m_ownsWaiter = owned;
+    m_missedWakeups = 0;
+}
+
+bool SharedRingSource::mapRing(int fd, off_t offset) {
+    void* mapped = mmap(0, PRU_MEM_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, offset);
+    if (mapped == MAP_FAILED) {
+        close();
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_map = mapped;
+    m_ring.attach(mapped);
+    m_captureHz = 0;
+    m_captureClock.reset(0);
+    return true;
+}
+
+void SharedRingSource::close() {
+    m_ring.detach();
+    if (m_map) {
+        munmap(m_map, PRU_MEM_SIZE);
+        m_map = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+const uint16_t* SharedRingSource::acquire(int timeoutMs) {
+    const volatile uint16_t* slot = m_ring.peek();
+    m_lastWaitNs = 0;
+    if (slot) {
+        updateCaptureTime();
+        return (const uint16_t*)slot;  // catching up, no need to sleep
+    }
+
+    // Sleep until the producer publishes the next slot
+    uint64_t start = monotonicNs();
+    uint64_t deadline = start + (uint64_t)timeoutMs * 1000000ULL;
+    while (!slot) {
+        uint64_t now = monotonicNs();
+        if (now >= deadline) {
+            break;
+        }
+        int remainingMs = (int)((deadline - now + 999999) / 1000000);
+
+        if (!m_ring.isReady()) {
+            // Producer hasn't initialized the header yet
+            usleep(qMin(remainingMs, 10) * 1000);
+            slot = m_ring.peek();
+            continue;
+        }
+
+        bool woken = m_waiter->wait(m_ring.writeSeqAddress(), m_ring.readSeq(), remainingMs);
+        slot = m_ring.peek();
+
+        // Data arrived without a wakeup: the event isn't wired up (wrong
+        // UIO node, producer that doesn't FUTEX_WAKE). Don't keep paying
+        // full timeouts for it.
+        if (!woken && slot && ++m_missedWakeups >= 3) {
+            qWarning() << "No wakeups from" << m_waiter->name() << "- falling back to polling";
+            setWaiter(new PollWaiter);
+        } else if (woken) {
+            m_missedWakeups = 0;
+        }
+    }
+    m_lastWaitNs = monotonicNs() - start;
+    if (slot) {
+        updateCaptureTime();
+    }
+
+    // peek() fenced after reading write_seq and the producer only touches
+    // this slot again after lapping us, which release() detects, so the
+    // samples can be read as plain memory
+    return (const uint16_t*)slot;
+}
+
+bool SharedRingSource::readCaptureCounter(uint32_t *count) const {
+    if (m_ring.stampHz() != 1000000) {
+        return false;
+    }
+    *count = (uint32_t)(monotonicNs() / 1000);
+    return true;
+}
+
+void SharedRingSource::correlateCaptureClock() {
+    // Best of a few reads; a preempted one just has a wider bracket
+    m_captureClock.beginRound();
+    for (int i = 0; i < 3; i++) {
+        uint32_t count;
+        uint64_t before = monotonicNs();
+        if (!readCaptureCounter(&count)) {
+            qWarning() << "Cannot read the ring's capture clock - latency is measured from arrival";
+            m_captureClock.reset(0);
+            return;
+        }
+        m_captureClock.addSample(before, count, monotonicNs());
+    }
+}
+
+void SharedRingSource::updateCaptureTime() {
+    uint64_t now = monotonicNs();
+    uint32_t hz = m_ring.stampHz();
+    if (hz != m_captureHz) {
+        m_captureHz = hz;
+        m_captureClock.reset(hz);
+    }
+    if (m_captureClock.due(now)) {
+        correlateCaptureClock();
+    }
+
+    // The slot was completed before we could see it: a stamp mapping to
+    // the future is a bad correlation, not a negative latency
+    m_lastCaptureNs = now;
+    if (m_captureClock.valid()) {
+        m_lastCaptureNs = qMin(now, m_captureClock.toMonotonicNs(m_ring.slotStamp()));
+    }
+}
+
+void SharedRingSource::release() {
+    // A lapped slot has a mix of old and new samples; it has already been
+    // used, but shows up in the torn count
+    m_ring.release();
+}
+
+QString SharedRingSource::statusText() const {
+    return QString("Ring lag: %1 dropped: %2 torn: %3 PRU overruns: %4 wait: %5")
+            .arg(m_ring.pending())
+            .arg(m_ring.droppedSlots())
+            .arg(m_ring.tornSlots())
+            .arg(m_ring.overrunCount())
+            .arg(m_waiter->name());
+}
+
+PRUSampleSource::PRUSampleSource(const QString &uioDevice)
+        : m_uioDevice(uioDevice)
+        , m_iepMap(nullptr)
+{
+}
+
+bool PRUSampleSource::open() {
+    int fd = ::open("/dev/mem", O_RDWR | O_SYNC);
+    if (fd < 0) {
+        return false;
+    }
+    if (!mapRing(fd, PRU_SHARED_MEM)) {
+        return false;
+    }
+
+    // IEP timer registers, for correlating the slot timestamps; without
+    // them spectra are just timed from arrival
+    void *iep = mmap(0, PRU_IEP_MAP_SIZE, PROT_READ, MAP_SHARED, fd, PRU_IEP_ARM_ADDRESS);
+    m_iepMap = iep == MAP_FAILED ? nullptr : iep;
+
+    if (!m_uioDevice.isEmpty()) {
+        UioWaiter *uio = new UioWaiter;
+        if (uio->open(m_uioDevice)) {
+            setWaiter(uio);
+        } else {
+            qWarning() << "Cannot open" << m_uioDevice << "- polling for PRU buffers";
+            delete uio;
+        }
+    }
+    return true;
+}
+
+void PRUSampleSource::close() {
+    if (m_iepMap) {
+        munmap(m_iepMap, PRU_IEP_MAP_SIZE);
+        m_iepMap = nullptr;
+    }
+    SharedRingSource::close();
+}
+
+bool PRUSampleSource::readCaptureCounter(uint32_t *count) const {
+    if (!m_iepMap || m_ring.stampHz() != PRU_IEP_HZ) {
+        return false;
+    }
+    *count = *(volatile uint32_t*)((volatile uint8_t*)m_iepMap + PRU_IEP_OFF_COUNT);
+    return true;
+}
+
+QString PRUSampleSource::description() const {
+    return QString("PRU shared memory (/dev/mem, %1)").arg(m_waiter->name());
+}
+
+ShmSampleSource::ShmSampleSource(const QString &name)
+        : m_path(name.startsWith("/") ? name : "/dev/shm/" + name)
+{
+}
+
+bool ShmSampleSource::open() {
+    // Create it if the producer isn't running yet; it attaches to the
+    // same file and initializes the header when it starts
+    int fd = ::open(m_path.toLocal8Bit().constData(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (st.st_size < PRU_MEM_SIZE && ftruncate(fd, PRU_MEM_SIZE) < 0)) {
+        ::close(fd);
+        return false;
+    }
+    if (!mapRing(fd, 0)) {
+        return false;
+    }
+    setWaiter(new FutexWaiter);
+    return true;
+}
+
+QString ShmSampleSource::description() const {
+    return QString("simulated PRU ring (%1)").arg(m_path);
+}
+
+SimulatedPRUSource::SimulatedPRUSource(SampleSource *generator)
+        : m_generator(generator)
+        , m_producing(false)
+{
+    // Producer keeps notifying m_eventFd even if acquire() swaps waiters
+    setWaiter(&m_eventFd, false);
+}
+
+SimulatedPRUSource::~SimulatedPRUSource() {
+    SimulatedPRUSource::close();
+    delete m_generator;
+}
+
+bool SimulatedPRUSource::open() {
+    if (!m_eventFd.isValid() || !m_generator->open()) {
+        return false;
+    }
+
+    // Private shared-RAM stand-in; the header starts zeroed (not ready)
+    void* mapped = mmap(0, PRU_MEM_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    m_map = mapped;
+
+    volatile pru_ring_header *ring = (volatile pru_ring_header*)mapped;
+    ring->version = PRU_RING_VERSION;
+    ring->stamp_hz = 1000000;   // CLOCK_MONOTONIC microseconds
+    ring->num_slots = PRU_RING_NUM_SLOTS;
+    ring->slot_samples = PRU_RING_SLOT_SAMPLES;
+    ring->magic = PRU_RING_MAGIC;
+    m_ring.attach(mapped);
+
+    m_producing = true;
+    m_producer = std::thread(&SimulatedPRUSource::produce, this);
+    return true;
+}
+
+void SimulatedPRUSource::close() {
+    m_producing = false;
+    if (m_producer.joinable()) {
+        m_producer.join();
+    }
+    m_generator->close();
+    SharedRingSource::close();
+}
+
+QString SimulatedPRUSource::description() const {
+    return QString("simulated PRU thread (%1)").arg(m_generator->description());
+}
+
+void SimulatedPRUSource::produce() {
+    volatile pru_ring_header *ring = (volatile pru_ring_header*)m_map;
+    uint32_t write_seq = 0;
+
+    while (m_producing) {
+        // Generator sleeps until the block is "captured"
+        const uint16_t *block = m_generator->acquire(100);
+        if (!block) {
+            continue;
+        }
+
+        volatile uint16_t *slot = pru_ring_slot(m_map, write_seq);
+        for (int i = 0; i < PRU_RING_SLOT_SAMPLES; i++) {
+            slot[i] = block[i];
+        }
+        m_generator->release();
+
+        // Stamp and publish slot, same protocol as the firmware
+        ring->slot_stamp[write_seq % PRU_RING_NUM_SLOTS] = (uint32_t)(monotonicNs() / 1000);
+        std::atomic_thread_fence(std::memory_order_release);
+        ring->write_seq = ++write_seq;
+        if (write_seq - ring->read_seq >= PRU_RING_NUM_SLOTS) {
+            ring->overrun_count++;
+        }
+        m_eventFd.notify();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// PacedSource
+// ---------------------------------------------------------------------------
+PacedSource::PacedSource(int sampleRate, int blockSize, bool realtime)
+        : m_sampleRate(sampleRate > 0 ? sampleRate : 48000)
+        , m_blockSize(blockSize > 0 ? blockSize : 1024)
+        , m_realtime(realtime)
+        , m_pacingStarted(false)
+{
+    m_block.resize(m_blockSize);
+}
+
+void PacedSource::resetPacing() {
+    m_pacingStarted = false;
+}
+
+const uint16_t* PacedSource::acquire(int timeoutMs) {
+    m_lastWaitNs = 0;
+    if (m_realtime) {
+        // Hand out blocks no faster than they would arrive from the ADC
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (!m_pacingStarted) {
+            m_nextDeadline = now;
+            m_pacingStarted = true;
+        }
+
+        int64_t waitNs = (m_nextDeadline.tv_sec - now.tv_sec) * 1000000000LL +
+                         (m_nextDeadline.tv_nsec - now.tv_nsec);
+        if (waitNs > (int64_t)timeoutMs * 1000000LL) {
+            return nullptr;
+        }
+        if (waitNs > 0) {
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &m_nextDeadline, nullptr);
+            m_lastWaitNs = waitNs;
+        }
+
+        // The block is "captured" at its deadline
+        m_lastCaptureNs = (uint64_t)m_nextDeadline.tv_sec * 1000000000ULL + m_nextDeadline.tv_nsec;
+
+        int64_t periodNs = (int64_t)m_blockSize * 1000000000LL / m_sampleRate;
+        m_nextDeadline.tv_nsec += periodNs;
+        while (m_nextDeadline.tv_nsec >= 1000000000L) {
+            m_nextDeadline.tv_nsec -= 1000000000L;
+            m_nextDeadline.tv_sec++;
+        }
+    }
+
+    if (!fillBlock()) {
+        return nullptr;
+    }
+    if (!m_realtime) {
+        m_lastCaptureNs = monotonicNs();
+    }
+    return m_block.constData();
+}
+
+// ---------------------------------------------------------------------------
+// FileSampleSource
+// ---------------------------------------------------------------------------
+FileSampleSource::FileSampleSource(const QString &path, int rawSampleRate,
+                                   int blockSize, bool loop, bool realtime)
+        : PacedSource(rawSampleRate, blockSize, realtime)
+        , m_path(path)
+        , m_loop(loop)
+        , m_atEnd(false)
+        , m_isWav(false)
+        , m_format(1)
+        , m_channels(1)
+        , m_bytesPerSample(2)
+        , m_dataOffset(0)
+        , m_dataSize(0)
+        , m_dataPos(0)
+{
+}
+
+static uint32_t readLE32(const char *p) {
+    const uint8_t *u = (const uint8_t*)p;
+    return u[0] | (u[1] << 8) | (u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+static uint16_t readLE16(const char *p) {
+    const uint8_t *u = (const uint8_t*)p;
+    return u[0] | (u[1] << 8);
+}
+
+bool FileSampleSource::parseWavHeader() {
+    char riff[12];
+    if (m_file.read(riff, 12) != 12 || memcmp(riff, "RIFF", 4) || memcmp(riff + 8, "WAVE", 4))
+        return false;
+
+    bool haveFormat = false;
+    char chunk[8];
+    while (m_file.read(chunk, 8) == 8) {
+        uint32_t chunkSize = readLE32(chunk + 4);
+
+        if (!memcmp(chunk, "fmt ", 4)) {
+            char fmt[16];
+            if (chunkSize < 16 || m_file.read(fmt, 16) != 16)
+                return false;
+            m_format = readLE16(fmt);
+            m_channels = readLE16(fmt + 2);
+            uint32_t sampleRate = readLE32(fmt + 4);
+            if (sampleRate == 0 || sampleRate > INT_MAX)
+                return false;   // pacing and DSPThread divide by it
+            m_sampleRate = sampleRate;
+            m_bytesPerSample = readLE16(fmt + 14) / 8;
+            if (m_format == 0xFFFE && chunkSize >= 26) {
+                // WAVE_FORMAT_EXTENSIBLE: real format is the first word of the GUID
+                char ext[10];
+                if (m_file.read(ext, 10) != 10)
+                    return false;
+                m_format = readLE16(ext + 8);
+                chunkSize -= 10;
+            }
+            haveFormat = true;
+            m_file.seek(m_file.pos() + chunkSize - 16 + (chunkSize & 1));
+        } else if (!memcmp(chunk, "data", 4)) {
+            m_dataOffset = m_file.pos();
+            m_dataSize = chunkSize;
+            break;
+        } else {
+            m_file.seek(m_file.pos() + chunkSize + (chunkSize & 1));
+        }
+    }
+
+    if (!haveFormat || m_dataOffset == 0 || m_channels < 1)
+        return false;
+    if (m_format == 1 && (m_bytesPerSample < 1 || m_bytesPerSample > 4))
+        return false;
+    if (m_format == 3 && m_bytesPerSample != 4)
+        return false;
+    return m_format == 1 || m_format == 3;
+}
+
+bool FileSampleSource::open() {
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    char magic[4];
+    m_isWav = m_file.read(magic, 4) == 4 && !memcmp(magic, "RIFF", 4);
+    m_file.seek(0);
+
+    if (m_isWav) {
+        if (!parseWavHeader()) {
+            m_file.close();
+            return false;
+        }
+        // Truncated files claim more data than they have
+        m_dataSize = qMin(m_dataSize, m_file.size() - m_dataOffset);
+    } else {
+        // Raw capture: little-endian uint16 ADC codes, one channel
+        m_format = 0;
+        m_channels = 1;
+        m_bytesPerSample = 2;
+        m_dataOffset = 0;
+        m_dataSize = m_file.size();
+    }
+
+    m_block.resize(m_blockSize);
+    m_readBuffer.resize(m_blockSize * m_channels * m_bytesPerSample);
+    m_dataPos = 0;
+    m_atEnd = false;
+    m_file.seek(m_dataOffset);
+    resetPacing();
+    return m_dataSize >= m_channels * m_bytesPerSample;
+}
+
+void FileSampleSource::close() {
+    m_file.close();
+}
+
+QString FileSampleSource::description() const {
+    return QString("%1 file %2 (%3 Hz%4)")
+            .arg(m_isWav ? "WAV" : "raw").arg(m_path).arg(m_sampleRate)
+            .arg(m_loop ? ", looping" : "");
+}
+
+uint16_t FileSampleSource::decodeFrame(const char *frame) const {
+    // First channel only; map [-1, 1] onto the ADC's 0-1.8V range
+    double x;
+    switch (m_format) {
+    case 0:
+        return qMin<uint16_t>(readLE16(frame), ADC_FULL_SCALE_CODE);
+    case 3: {
+        uint32_t bits = readLE32(frame);
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        x = f;
+        break;
+    }
+    default:
+        if (m_bytesPerSample == 1) {
+            x = ((uint8_t)frame[0] - 128) / 128.0;  // 8-bit WAV is unsigned
+        } else {
+            // Left-justify into 32 bits so every width scales the same
+            uint32_t v = 0;
+            for (int b = 0; b < m_bytesPerSample; b++)
+                v |= (uint32_t)(uint8_t)frame[b] << (8 * (4 - m_bytesPerSample + b));
+            x = (int32_t)v / 2147483648.0;
+        }
+        break;
+    }
+    return voltsToCode((x + 1.0) * 0.5 * ADC_FULL_SCALE_VOLTS);
+}
+
+bool FileSampleSource::fillBlock() {
+    const int frameBytes = m_channels * m_bytesPerSample;
+    int filled = 0;
+    // Rewound and nothing read since: a data chunk shorter than one frame,
+    // or reads that keep failing, must not loop forever
+    bool rewound = false;
+
+    while (filled < m_blockSize) {
+        if (m_dataPos + frameBytes > m_dataSize) {
+            if (!m_loop || rewound) {
+                break;
+            }
+            m_file.seek(m_dataOffset);
+            m_dataPos = 0;
+            rewound = true;
+        }
+
+        qint64 frames = qMin<qint64>(m_blockSize - filled, (m_dataSize - m_dataPos) / frameBytes);
+        qint64 got = m_file.read(m_readBuffer.data(), frames * frameBytes);
+        if (got < frameBytes) {
+            m_dataPos = m_dataSize;  // short read: treat as end of data
+            continue;
+        }
+        rewound = false;
+        frames = got / frameBytes;
+        for (qint64 i = 0; i < frames; i++) {
+            m_block[filled++] = decodeFrame(m_readBuffer.constData() + i * frameBytes);
+        }
+        m_dataPos += frames * frameBytes;
+    }
+
+    if (filled == 0) {
+        m_atEnd = true;
+        return false;
+    }
+
+    // Pad the final partial block with mid-scale (silence)
+    for (int i = filled; i < m_blockSize; i++) {
+        m_block[i] = (ADC_FULL_SCALE_CODE + 1) / 2;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SignalGeneratorSource
+// ---------------------------------------------------------------------------
+SignalGeneratorSource::SignalGeneratorSource(int sampleRate, int blockSize, bool realtime)
+        : PacedSource(sampleRate, blockSize, realtime)
+        , m_noiseRms(0.0)
+        , m_pinkRms(0.0)
+        , m_dc(0.9)
+        , m_stepAt(0)
+        , m_stepVolts(0.0)
+        , m_length(0)
+        , m_produced(0)
+        , m_rng(12345)
+{
+    memset(m_pinkState, 0, sizeof(m_pinkState));
+}
+
+void SignalGeneratorSource::addTone(double frequency, double amplitude) {
+    Tone tone = { frequency, amplitude, 0.0 };
+    m_tones.append(tone);
+}
+
+bool SignalGeneratorSource::open() {
+    for (Tone &tone : m_tones) {
+        tone.phase = 0.0;
+    }
+    memset(m_pinkState, 0, sizeof(m_pinkState));
+    m_produced = 0;
+    resetPacing();
+    return true;
+}
+
+QString SignalGeneratorSource::description() const {
+    QStringList parts;
+    for (const Tone &tone : m_tones) {
+        parts.append(QString("%1 Hz @ %2 Vpk").arg(tone.frequency).arg(tone.amplitude));
+    }
+    if (m_noiseRms > 0.0) {
+        parts.append(QString("noise %1 Vrms").arg(m_noiseRms));
+    }
+    if (m_pinkRms > 0.0) {
+        parts.append(QString("pink noise %1 Vrms").arg(m_pinkRms));
+    }
+    if (m_stepAt) {
+        parts.append(QString("DC step %1 V at sample %2").arg(m_stepVolts).arg(m_stepAt));
+    }
+    return QString("signal generator (%1, %2 Hz)").arg(parts.join(", ")).arg(m_sampleRate);
+}
+
+bool SignalGeneratorSource::fillBlock() {
+    if (atEnd()) {
+        return false;
+    }
+    for (int i = 0; i < m_blockSize; i++) {
+        double value = m_dc;
+        if (m_stepAt && m_produced + i >= m_stepAt) {
+            value += m_stepVolts;
+        }
+        for (Tone &tone : m_tones) {
+            value += tone.amplitude * sin(tone.phase);
+        }
+        if (m_noiseRms > 0.0) {
+            value += m_noiseRms * m_gauss(m_rng);
+        }
+        if (m_pinkRms > 0.0) {
+            // Paul Kellet's refined pinking filter: -3 dB/octave within
+            // ~0.1 dB from 10 Hz up to ~13 kHz at 48 kHz. 3.05 is its RMS
+            // gain for unit white noise.
+            double white = m_gauss(m_rng);
+            double *b = m_pinkState;
+            b[0] = 0.99886 * b[0] + white * 0.0555179;
+            b[1] = 0.99332 * b[1] + white * 0.0750759;
+            b[2] = 0.96900 * b[2] + white * 0.1538520;
+            b[3] = 0.86650 * b[3] + white * 0.3104856;
+            b[4] = 0.55000 * b[4] + white * 0.5329522;
+            b[5] = -0.7616 * b[5] - white * 0.0168980;
+            double pink = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362;
+            b[6] = white * 0.115926;
+            value += m_pinkRms / 3.0525 * pink;
+        }
+        m_block[i] = voltsToCode(value);
+
+        // Advance phases, wrapped so they stay precise over long runs
+        for (Tone &tone : m_tones) {
+            tone.phase += 2.0 * M_PI * tone.frequency / m_sampleRate;
+            while (tone.phase >= 2.0 * M_PI)
+                tone.phase -= 2.0 * M_PI;
+        }
+    }
+    m_produced += m_blockSize;
+    return true;
+}
@@ -0,0 +1,280 @@
+#ifndef SAMPLESOURCE_H
+#define SAMPLESOURCE_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <cstdint>
+#include <atomic>
+#include <ctime>
+#include <random>
+#include <thread>
+#include "pruring.h"
+#include "bufferwaiter.h"
+#include "captureclock.h"
+
+// Where DSPThread gets raw samples from. Every backend hands out blocks of
+// 12-bit ADC codes (0-4095 = 0-1.8V, like the AM335x ADC) so the DSP path
+// doesn't care whether they came from the PRU, a file or a generator.
+class SampleSource {
+public:
+    SampleSource() : m_lastWaitNs(0), m_lastCaptureNs(0) {}
+    virtual ~SampleSource() {}
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual QString description() const = 0;
+
+    virtual int sampleRate() const = 0;
+    virtual int blockSize() const = 0;
+
+    // Wait up to timeoutMs for the next block of blockSize() samples.
+    // Returns nullptr on timeout or end of input. The block stays valid
+    // until release().
+    virtual const uint16_t* acquire(int timeoutMs) = 0;
+    virtual void release() = 0;
+
+    // Blocks ready but not yet acquired / lost because we fell behind
+    virtual uint32_t pending() const { return 0; }
+    virtual uint64_t droppedBlocks() const { return 0; }
+
+    // Finite sources (files without loop) run out
+    virtual bool atEnd() const { return false; }
+
+    // Backend specific counters for the periodic stats line
+    virtual QString statusText() const { return QString(); }
+
+    // How long the last acquire() slept waiting for data
+    uint64_t lastWaitNs() const { return m_lastWaitNs; }
+
+    // CLOCK_MONOTONIC when the last acquired block's final sample was
+    // captured: the producer's timestamp where it has one (PRU ring
+    // version 2), the pacing deadline for real-time generators, otherwise
+    // when acquire() got the block
+    uint64_t lastCaptureNs() const { return m_lastCaptureNs; }
+
+    // Build a source from a command line spec:
+    //   pru[:uio=<dev>|poll]       PRU shared RAM via /dev/mem, woken by the
+    //                              PRU interrupt on <dev> (default /dev/uio0)
+    //   shm[:name]                 ring in /dev/shm/<name> (default pru_ring),
+    //                              woken by futex
+    //   sim[:key=value,...]        in-process simulated PRU thread feeding a
+    //                              ring, woken by eventfd; gen keys apply
+    //   file:<path>[,key=value]    .wav, or raw little-endian uint16 ADC codes
+    //                              keys: rate, block, loop, realtime
+    //   gen[:key=value,...]        signal generator, see SignalGeneratorSource
+    static SampleSource* create(const QString &spec, QString *error = nullptr);
+
+protected:
+    uint64_t m_lastWaitNs;
+    uint64_t m_lastCaptureNs;
+};
+
+// ---------------------------------------------------------------------------
+// Ring backends: anything laid out like PRU shared RAM (see pru/pru_ring.h)
+// ---------------------------------------------------------------------------
+class SharedRingSource : public SampleSource {
+public:
+    SharedRingSource();
+    ~SharedRingSource();
+
+    void close() override;
+    int sampleRate() const override { return 48000; }  // PRU firmware rate
+    int blockSize() const override { return PRU_RING_SLOT_SAMPLES; }
+
+    const uint16_t* acquire(int timeoutMs) override;
+    void release() override;
+
+    uint32_t pending() const override { return m_ring.pending(); }
+    uint64_t droppedBlocks() const override { return m_ring.droppedSlots(); }
+    QString statusText() const override;
+
+protected:
+    bool mapRing(int fd, off_t offset);
+    void setWaiter(BufferWaiter *waiter, bool owned = true);
+
+    // Reads the producer's timestamp clock now. The default is for the
+    // simulators, which stamp CLOCK_MONOTONIC microseconds.
+    virtual bool readCaptureCounter(uint32_t *count) const;
+
+    PRURingReader m_ring;
+    BufferWaiter *m_waiter;
+    void *m_map;
+    int m_fd;
+
+private:
+    void updateCaptureTime();
+    void correlateCaptureClock();
+
+    bool m_ownsWaiter;
+    int m_missedWakeups;
+    uint32_t m_captureHz;   // ring's stamp_hz m_captureClock was set up for
+    CaptureClock m_captureClock;
+};
+
+// The real thing: PRU shared RAM at 0x4A310000 through /dev/mem
+class PRUSampleSource : public SharedRingSource {
+public:
+    // Empty uioDevice: poll write_seq instead of waiting for the interrupt
+    explicit PRUSampleSource(const QString &uioDevice = "/dev/uio0");
+
+    bool open() override;
+    void close() override;
+    QString description() const override;
+
+protected:
+    // The IEP counter register, mapped next to shared RAM
+    bool readCaptureCounter(uint32_t *count) const override;
+
+private:
+    QString m_uioDevice;
+    void *m_iepMap;
+};
+
+// File-backed ring in /dev/shm with the PRU layout, so a local process
+// (pru_sim) can stand in for the PRU on a machine without one
+class ShmSampleSource : public SharedRingSource {
+public:
+    explicit ShmSampleSource(const QString &name);
+
+    bool open() override;
+    QString description() const override;
+
+private:
+    QString m_path;
+};
+
+// In-process stand-in for the PRU: a producer thread copies generator
+// blocks into a private ring with the PRU layout and signals an eventfd.
+// Exercises the whole ring/wait path without a second process.
+class SimulatedPRUSource : public SharedRingSource {
+public:
+    // Takes ownership of generator, which should be paced in real time
+    explicit SimulatedPRUSource(SampleSource *generator);
+    ~SimulatedPRUSource();
+
+    bool open() override;
+    void close() override;
+    QString description() const override;
+
+private:
+    void produce();
+
+    SampleSource *m_generator;
+    EventFdWaiter m_eventFd;
+    std::thread m_producer;
+    std::atomic<bool> m_producing;
+};
+
+// ---------------------------------------------------------------------------
+// Generated backends, optionally paced to real time
+// ---------------------------------------------------------------------------
+class PacedSource : public SampleSource {
+public:
+    PacedSource(int sampleRate, int blockSize, bool realtime);
+
+    int sampleRate() const override { return m_sampleRate; }
+    int blockSize() const override { return m_blockSize; }
+
+    const uint16_t* acquire(int timeoutMs) override;
+    void release() override {}
+
+protected:
+    // Fill m_block with the next blockSize() samples; false at end of input
+    virtual bool fillBlock() = 0;
+    void resetPacing();
+
+    QVector<uint16_t> m_block;
+    int m_sampleRate;
+    int m_blockSize;
+    bool m_realtime;
+
+private:
+    struct timespec m_nextDeadline;
+    bool m_pacingStarted;
+};
+
+// WAV (PCM 8/16/24/32-bit or float, first channel used) or raw uint16 codes
+class FileSampleSource : public PacedSource {
+public:
+    FileSampleSource(const QString &path, int rawSampleRate, int blockSize,
+                     bool loop, bool realtime);
+
+    bool open() override;
+    void close() override;
+    QString description() const override;
+    bool atEnd() const override { return m_atEnd; }
+
+protected:
+    bool fillBlock() override;
+
+private:
+    bool parseWavHeader();
+    uint16_t decodeFrame(const char *frame) const;
+
+    QFile m_file;
+    QString m_path;
+    bool m_loop;
+    bool m_atEnd;
+
+    bool m_isWav;
+    int m_format;         // 1 = PCM, 3 = IEEE float
+    int m_channels;
+    int m_bytesPerSample;
+    qint64 m_dataOffset;
+    qint64 m_dataSize;
+    qint64 m_dataPos;
+    QByteArray m_readBuffer;
+};
+
+// Parametric test signal:
+//   tone=<hz>[:<volts peak>][+<hz>[:<volts>]...]   default 10000:0.3
+//   noise=<volts rms>   white gaussian noise, default 0
+//   pink=<volts rms>    pink (-3 dB/octave) noise, default 0
+//   dc=<volts>          bias, default 0.9 (ADC mid-scale)
+//   step=<seconds>:<volts>   bias steps by <volts> at <seconds>
+//   duration=<seconds>  input ends after this long; default endless
+//   rate=<hz>, block=<samples>, realtime=0|1, seed=<n>
+// Anything outside 0-1.8V clips at the ADC's rails.
+class SignalGeneratorSource : public PacedSource {
+public:
+    struct Tone {
+        double frequency;
+        double amplitude;
+        double phase;
+    };
+
+    SignalGeneratorSource(int sampleRate, int blockSize, bool realtime);
+
+    void addTone(double frequency, double amplitude);
+    void setNoise(double rms) { m_noiseRms = rms; }
+    void setPinkNoise(double rms) { m_pinkRms = rms; }
+    void setDC(double volts) { m_dc = volts; }
+    void setDCStep(uint64_t atSample, double volts) { m_stepAt = atSample; m_stepVolts = volts; }
+    // 0: endless. Rounded up to whole blocks.
+    void setLength(uint64_t samples) { m_length = samples; }
+    void setSeed(unsigned seed) { m_rng.seed(seed); }
+
+    bool open() override;
+    void close() override {}
+    QString description() const override;
+    bool atEnd() const override { return m_length && m_produced >= m_length; }
+
+protected:
+    bool fillBlock() override;
+
+private:
+    QVector<Tone> m_tones;
+    double m_noiseRms;
+    double m_pinkRms;
+    double m_pinkState[7];   // pinking filter, see fillBlock()
+    double m_dc;
+    uint64_t m_stepAt;       // 0: no step
+    double m_stepVolts;
+    uint64_t m_length;
+    uint64_t m_produced;
+    std::mt19937 m_rng;
+    std::normal_distribution<double> m_gauss;
+};
+
+#endif
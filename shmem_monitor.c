@@ -8,9 +8,11 @@
 #include <time.h>
 #include <math.h>
 
+#include "pru/pru_ring.h"
+
 #define PRU_SHARED_MEM 0x4A310000
 #define PRU_MEM_SIZE 0x3000
-#define BUFFER_SIZE 1024
+#define BUFFER_SIZE PRU_RING_SLOT_SAMPLES
 
 volatile int keep_running = 1;
 
@@ -52,8 +54,7 @@ void analyze_buffer(volatile uint16_t* buffer, const char* name) {
 int main() {
     int mem_fd;
     void *shared_map;
-    volatile uint16_t *buffer_a, *buffer_b;
-    volatile uint8_t *ready_flag;
+    volatile struct pru_ring_header *ring;
 
     printf("Shared Memory Monitor\n");
     printf("=====================\n\n");
@@ -75,57 +76,56 @@ int main() {
         return 1;
     }
 
-    buffer_a = (volatile uint16_t *)shared_map;
-    buffer_b = buffer_a + BUFFER_SIZE;
-    ready_flag = (volatile uint8_t *)((char*)shared_map + 0x1000);
+    ring = (volatile struct pru_ring_header *)((char*)shared_map + PRU_RING_HEADER_OFFSET);
 
     printf("Mapped shared memory at %p\n", shared_map);
-    printf("Buffer A: %p\n", (void*)buffer_a);
-    printf("Buffer B: %p\n", (void*)buffer_b);
-    printf("Ready flag: %p\n\n", (void*)ready_flag);
+    printf("Ring header: %p\n", (void*)ring);
+    printf("Slots: %d x %d samples at %p\n\n", PRU_RING_NUM_SLOTS, PRU_RING_SLOT_SAMPLES,
+           (void*)pru_ring_slot(shared_map, 0));
 
     printf("Monitoring (Ctrl+C to stop)...\n\n");
 
-    int snapshot_count = 0;
-    uint8_t last_flag = *ready_flag;
     struct timespec last_time, current_time;
     int buffer_count = 0;
 
-    // Wait for first flag change
-    printf("Waiting for PRU to set ready flag...\n");
-    while (*ready_flag == 0 && keep_running) {
+    // Wait for the producer to initialize the ring. This monitor is a
+    // passive observer: it never writes read_seq, so it doesn't disturb
+    // the real consumer.
+    printf("Waiting for PRU to initialize ring...\n");
+    while (ring->magic != PRU_RING_MAGIC && keep_running) {
         usleep(10000);
     }
-    last_flag = *ready_flag;
+    uint32_t last_seq = ring->write_seq;
     clock_gettime(CLOCK_MONOTONIC, &last_time);
-    printf("PRU is running!\n\n");
+    printf("PRU is running (write_seq %u)!\n\n", last_seq);
 
     while (keep_running) {
-        uint8_t flag = *ready_flag;
+        uint32_t write_seq = ring->write_seq;
 
-        if (flag != 0 && flag != last_flag) {
-            // Flag changed - new buffer ready
+        if (write_seq != last_seq) {
+            // One or more slots published since last check
             clock_gettime(CLOCK_MONOTONIC, &current_time);
 
             double elapsed = (current_time.tv_sec - last_time.tv_sec) +
                            (current_time.tv_nsec - last_time.tv_nsec) / 1e9;
-            double sample_rate = BUFFER_SIZE / elapsed;
+            uint32_t new_slots = write_seq - last_seq;
+            double sample_rate = new_slots * BUFFER_SIZE / elapsed;
 
-            buffer_count++;
+            buffer_count += new_slots;
 
             printf("=== Buffer %d ===\n", buffer_count);
-            printf("Ready Flag: %d -> %d\n", last_flag, flag);
+            printf("write_seq: %u -> %u (+%u)  read_seq: %u  lag: %u  overruns: %u\n",
+                   last_seq, write_seq, new_slots, ring->read_seq,
+                   write_seq - ring->read_seq, ring->overrun_count);
             printf("Time: %.6f sec (%.1f Hz sample rate)\n", elapsed, sample_rate);
             printf("\n");
 
-            if (flag == 1) {
-                analyze_buffer(buffer_a, "Buffer A");
-            } else if (flag == 2) {
-                analyze_buffer(buffer_b, "Buffer B");
-            }
+            char name[32];
+            snprintf(name, sizeof(name), "Slot %u", (write_seq - 1) % PRU_RING_NUM_SLOTS);
+            analyze_buffer(pru_ring_slot(shared_map, write_seq - 1), name);
             printf("\n");
 
-            last_flag = flag;
+            last_seq = write_seq;
             last_time = current_time;
         }
 
@@ -5,21 +5,94 @@ TEMPLATE = app
 
 CONFIG += c++11
 
+# Per-frame DSP kernels rely on the loop vectorizer, which GCC only runs
+# fully at -O3
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
 INCLUDEPATH += /home/stopkins/lab5/fftw-arm/include
 
 HEADERS = \
     mainwindow.h \
     dspthread.h \
     spectrumdata.h \
+    pruring.h \
+    samplesource.h \
+    bufferwaiter.h \
+    dspkernels.h \
+    samplehistory.h \
+    fftplancache.h \
+    windowtable.h \
+    triplebuffer.h \
+    spectrumbus.h \
+    spectrumtrace.h \
+    columndecimator.h \
+    spectrumrenderer.h \
+    spectrumview.h \
+    refreshscheduler.h \
+    waterfall.h \
+    waterfallplot.h \
+    persistencegrid.h \
+    persistence.h \
+    persistenceplot.h \
+    captureclock.h \
+    latencystats.h \
+    profiler.h \
+    profilemonitor.h \
+    spectrumwriter.h \
+    headless.h \
+    pru/pru_ring.h \
     qcustomplot.h
 
 SOURCES = \
     main.cpp \
     mainwindow.cpp \
     dspthread.cpp \
+    spectrumdata.cpp \
+    pruring.cpp \
+    samplesource.cpp \
+    bufferwaiter.cpp \
+    samplehistory.cpp \
+    fftplancache.cpp \
+    windowtable.cpp \
+    spectrumbus.cpp \
+    spectrumtrace.cpp \
+    columndecimator.cpp \
+    spectrumrenderer.cpp \
+    spectrumview.cpp \
+    refreshscheduler.cpp \
+    waterfall.cpp \
+    waterfallplot.cpp \
+    persistencegrid.cpp \
+    persistence.cpp \
+    persistenceplot.cpp \
+    captureclock.cpp \
+    latencystats.cpp \
+    profiler.cpp \
+    profilemonitor.cpp \
+    spectrumwriter.cpp \
+    headless.cpp \
     qcustomplot.cpp
 
-LIBS += -Wl,--whole-archive /home/stopkins/lab5/fftw-arm/lib/libfftw3.a -Wl,--no-whole-archive -lpthread -lm
+# float32 DSP path: GCC only hands single precision loops to NEON when it
+# may ignore NEON's flush-to-zero/no-NaN-traps differences from VFP. Only
+# the kernels get that; everything else (GUI, qcustomplot, the dB floor
+# handling outside the kernels) keeps strict IEEE semantics.
+contains(QT_ARCH, arm) {
+    NEON_SOURCES = dspkernels.cpp
+    neon.input = NEON_SOURCES
+    neon.output = ${QMAKE_VAR_OBJECTS_DIR}${QMAKE_FILE_IN_BASE}$${first(QMAKE_EXT_OBJ)}
+    neon.commands = $(CXX) -c $(CXXFLAGS) -mfpu=neon -funsafe-math-optimizations $(INCPATH) \
+                    ${QMAKE_FILE_IN} -o ${QMAKE_FILE_OUT}
+    neon.dependency_type = TYPE_C
+    neon.variable_out = OBJECTS
+    QMAKE_EXTRA_COMPILERS += neon
+} else {
+    SOURCES += dspkernels.cpp
+}
+
+# libfftw3f.a: the same FFTW build configured with --enable-float --enable-neon
+LIBS += -Wl,--whole-archive /home/stopkins/lab5/fftw-arm/lib/libfftw3.a /home/stopkins/lab5/fftw-arm/lib/libfftw3f.a -Wl,--no-whole-archive -lpthread -lm
 
 target.path = /root
 INSTALLS += target
@@ -0,0 +1,149 @@
+#include "spectrumbus.h"
+#include <algorithm>
+#include <chrono>
+
+SpectrumSubscription::SpectrumSubscription(const std::string &name, Policy policy, int depth)
+        : m_name(name)
+        , m_policy(policy)
+        , m_offered(0)
+        , m_closed(false)
+        , m_ring(policy == LatestOnly ? 0 : std::max(1, depth))
+        , m_head(0)
+        , m_count(0)
+        , m_dropped(0)
+{
+}
+
+uint64_t SpectrumSubscription::dropped() const {
+    if (m_policy == LatestOnly) {
+        return m_latest.overwritten();
+    }
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void SpectrumSubscription::offer(const SpectrumFrameRef &frame) {
+    m_offered.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_policy == LatestOnly) {
+        // What comes back out of the triple buffer is a frame the consumer
+        // has finished with or never took; dropping it returns it to the pool
+        m_latest.writeBuffer() = frame;
+        m_latest.publish();
+        m_latest.writeBuffer().reset();
+        if (m_notifier) {
+            m_notifier();
+        }
+        return;
+    }
+
+    const int depth = (int)m_ring.size();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_count == depth) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            if (m_policy == Blocking) {
+                return;
+            }
+            m_ring[m_head].reset();
+            m_head = (m_head + 1) % depth;
+            m_count--;
+        }
+        m_ring[(m_head + m_count) % depth] = frame;
+        m_count++;
+    }
+    m_ready.notify_one();
+    if (m_notifier) {
+        m_notifier();
+    }
+}
+
+SpectrumFrameRef SpectrumSubscription::take() {
+    SpectrumFrameRef frame;
+    if (m_policy == LatestOnly) {
+        const SpectrumFrameRef *latest = m_latest.acquire();
+        if (latest) {
+            frame = *latest;
+        }
+        return frame;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_count > 0) {
+        // Swap rather than copy so the slot gives up its reference
+        std::swap(frame, m_ring[m_head]);
+        m_head = (m_head + 1) % (int)m_ring.size();
+        m_count--;
+    }
+    return frame;
+}
+
+SpectrumFrameRef SpectrumSubscription::wait(int timeoutMs) {
+    if (m_policy == LatestOnly) {
+        return take();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_ready.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                     [this] { return m_count > 0 || m_closed; });
+    SpectrumFrameRef frame;
+    if (m_count > 0) {
+        std::swap(frame, m_ring[m_head]);
+        m_head = (m_head + 1) % (int)m_ring.size();
+        m_count--;
+    }
+    return frame;
+}
+
+void SpectrumSubscription::close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_ready.notify_all();
+}
+
+SpectrumBus::SpectrumBus()
+        : m_published(0)
+        , m_closed(false)
+{
+}
+
+SpectrumSubscriptionPtr SpectrumBus::subscribe(const std::string &name,
+                                               SpectrumSubscription::Policy policy,
+                                               int depth) {
+    SpectrumSubscriptionPtr subscription = std::make_shared<SpectrumSubscription>(name, policy, depth);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_closed) {
+        subscription->close();
+    } else {
+        m_subscribers.push_back(subscription);
+    }
+    return subscription;
+}
+
+void SpectrumBus::unsubscribe(const SpectrumSubscriptionPtr &subscription) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_subscribers.erase(std::remove(m_subscribers.begin(), m_subscribers.end(), subscription),
+                        m_subscribers.end());
+}
+
+void SpectrumBus::publish(const SpectrumFrameRef &frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const SpectrumSubscriptionPtr &subscription : m_subscribers) {
+        subscription->offer(frame);
+    }
+    m_published.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SpectrumBus::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    for (const SpectrumSubscriptionPtr &subscription : m_subscribers) {
+        subscription->close();
+    }
+}
+
+std::vector<SpectrumSubscriptionPtr> SpectrumBus::subscriptions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_subscribers;
+}
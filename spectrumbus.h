@@ -0,0 +1,114 @@
+#ifndef SPECTRUMBUS_H
+#define SPECTRUMBUS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "spectrumdata.h"
+#include "triplebuffer.h"
+
+// Broadcast of published spectra to any number of consumers (UI, recorder,
+// metrics, network). Every subscriber gets a reference to the same pooled
+// frame - nothing is copied - and its own drop policy, so a consumer that
+// falls behind only ever loses its own frames. The publisher never waits
+// on a subscriber: the most it does is take a subscriber's queue lock for
+// a push or a pop.
+
+class SpectrumSubscription {
+public:
+    enum Policy {
+        // Only the newest frame is kept, older ones are replaced. Wait-free
+        // (triple buffer); take() from one consumer thread only. For the UI.
+        LatestOnly,
+        // Bounded FIFO that drops its oldest frame when full, so the
+        // consumer always sees the most recent `depth` spectra
+        Queue,
+        // Bounded FIFO that drops the new frame when full, so what the
+        // consumer gets is gap free up to the first overflow (the gap shows
+        // in SpectrumData::sequence). The consumer blocks in wait(); the
+        // publisher still never does. For recorders.
+        Blocking
+    };
+
+    SpectrumSubscription(const std::string &name, Policy policy, int depth);
+
+    const std::string& name() const { return m_name; }
+    Policy policy() const { return m_policy; }
+
+    // Next frame, or an empty reference if there is none yet
+    SpectrumFrameRef take();
+
+    // Like take(), but waits up to timeoutMs for a frame (Queue and
+    // Blocking only). Empty once the bus is closed and the queue drained.
+    SpectrumFrameRef wait(int timeoutMs);
+
+    bool closed() const { return m_closed; }
+
+    // Called on the publisher thread after each frame is offered, for
+    // consumers that want waking through their own event loop. Keep it
+    // short and non-blocking. Set before frames are published.
+    void setNotifier(const std::function<void()> &notifier) { m_notifier = notifier; }
+
+    // Frames offered to this subscriber, and those it lost to its policy
+    uint64_t offered() const { return m_offered.load(std::memory_order_relaxed); }
+    uint64_t dropped() const;
+
+private:
+    friend class SpectrumBus;
+    void offer(const SpectrumFrameRef &frame);   // publisher thread
+    void close();
+
+    std::string m_name;
+    Policy m_policy;
+    std::atomic<uint64_t> m_offered;
+    std::atomic<bool> m_closed;
+    std::function<void()> m_notifier;
+
+    // LatestOnly
+    TripleBuffer<SpectrumFrameRef> m_latest;
+
+    // Queue, Blocking: ring of m_ring.size() references
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::vector<SpectrumFrameRef> m_ring;
+    int m_head;
+    int m_count;
+    std::atomic<uint64_t> m_dropped;
+};
+
+typedef std::shared_ptr<SpectrumSubscription> SpectrumSubscriptionPtr;
+
+class SpectrumBus {
+public:
+    SpectrumBus();
+
+    // Thread safe. `depth` is the queue length for Queue and Blocking;
+    // queued frames stay out of the pool, which grows to cover them.
+    SpectrumSubscriptionPtr subscribe(const std::string &name,
+                                      SpectrumSubscription::Policy policy,
+                                      int depth = 8);
+    void unsubscribe(const SpectrumSubscriptionPtr &subscription);
+
+    // Publisher thread: hands the frame to every subscriber
+    void publish(const SpectrumFrameRef &frame);
+
+    // No more frames; wakes consumers blocked in wait()
+    void close();
+
+    // Snapshot of the current subscribers (allocates; for stats)
+    std::vector<SpectrumSubscriptionPtr> subscriptions() const;
+
+    uint64_t published() const { return m_published.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex m_mutex;   // m_subscribers; only held briefly
+    std::vector<SpectrumSubscriptionPtr> m_subscribers;
+    std::atomic<uint64_t> m_published;
+    bool m_closed;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "spectrumdata.h"
+#include <cstdlib>
+
+FrequencyAxis::FrequencyAxis(uint32_t sampleRate, uint32_t fftSize)
+        : m_sampleRate(sampleRate)
+        , m_fftSize(fftSize)
+        , m_frequencies(fftSize / 2)
+{
+    const double binWidth = (double)sampleRate / fftSize;
+    for (size_t i = 0; i < m_frequencies.size(); i++) {
+        m_frequencies[i] = (i + 1) * binWidth;
+    }
+}
+
+SpectrumData::SpectrumData()
+        : magnitudes(nullptr)
+        , numBins(0)
+        , enbw(1.0)
+        , sequence(0)
+        , m_capacity(0)
+        , m_refs(0)
+        , m_pool(nullptr)
+{
+}
+
+SpectrumData::~SpectrumData() {
+    free(magnitudes);
+}
+
+SpectrumFrameRef::SpectrumFrameRef(const SpectrumFrameRef &other)
+        : m_frame(other.m_frame)
+{
+    if (m_frame) {
+        m_frame->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SpectrumFrameRef& SpectrumFrameRef::operator=(const SpectrumFrameRef &other) {
+    if (other.m_frame != m_frame) {
+        if (other.m_frame) {
+            other.m_frame->m_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        reset();
+        m_frame = other.m_frame;
+    }
+    return *this;
+}
+
+void SpectrumFrameRef::reset() {
+    // acq_rel: the last holder must see every write made through the
+    // other references before the frame is reused
+    if (m_frame && m_frame->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_frame->m_pool->recycle(m_frame);
+    }
+    m_frame = nullptr;
+}
+
+SpectrumFramePool::SpectrumFramePool(int frames)
+        : m_grown(0)
+        , m_storageAllocations(0)
+{
+    m_all.reserve(frames);
+    m_free.reserve(frames);
+    for (int i = 0; i < frames; i++) {
+        SpectrumData *frame = create();
+        m_all.push_back(frame);
+        m_free.push_back(frame);
+    }
+}
+
+SpectrumFramePool::~SpectrumFramePool() {
+    for (SpectrumData *frame : m_all) {
+        delete frame;
+    }
+}
+
+SpectrumData* SpectrumFramePool::create() {
+    SpectrumData *frame = new SpectrumData;
+    frame->m_pool = this;
+    return frame;
+}
+
+SpectrumFrameRef SpectrumFramePool::acquire(int bins) {
+    SpectrumData *frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free.empty()) {
+            frame = m_free.back();
+            m_free.pop_back();
+        } else {
+            // Everything is referenced: grow, and keep the free list able
+            // to take every frame back without reallocating
+            frame = create();
+            m_all.push_back(frame);
+            m_free.reserve(m_all.capacity());
+            m_grown.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!ensureStorage(frame, bins)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(frame);
+        return SpectrumFrameRef();
+    }
+    frame->numBins = bins;
+    frame->m_refs.store(1, std::memory_order_relaxed);
+    return SpectrumFrameRef(frame);
+}
+
+void SpectrumFramePool::reserve(int bins) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (SpectrumData *frame : m_free) {
+        ensureStorage(frame, bins);
+    }
+}
+
+bool SpectrumFramePool::ensureStorage(SpectrumData *frame, int bins) {
+    // Storage only changes when the FFT size grows past what this frame
+    // has held before
+    if (frame->m_capacity >= bins) {
+        return true;
+    }
+    free(frame->magnitudes);
+    void *storage = nullptr;
+    if (posix_memalign(&storage, 64, sizeof(double) * bins) != 0) {
+        storage = nullptr;
+    }
+    frame->magnitudes = (double*)storage;
+    frame->m_capacity = storage ? bins : 0;
+    m_storageAllocations.fetch_add(1, std::memory_order_relaxed);
+    return storage != nullptr;
+}
+
+FrequencyAxisPtr SpectrumFramePool::axis(uint32_t sampleRate, uint32_t fftSize) {
+    if (!m_axis || !m_axis->matches(sampleRate, fftSize)) {
+        m_axis = std::make_shared<const FrequencyAxis>(sampleRate, fftSize);
+    }
+    return m_axis;
+}
+
+void SpectrumFramePool::recycle(SpectrumData *frame) {
+    // Let go of the axis here rather than on reuse, so an old configuration's
+    // axis is freed as soon as its last frame is
+    frame->axis.reset();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(frame);
+}
+
+int SpectrumFramePool::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_all.size();
+}
+
+int SpectrumFramePool::available() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_free.size();
+}
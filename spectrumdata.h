@@ -1,18 +1,142 @@
 #ifndef SPECTRUMDATA_H
 #define SPECTRUMDATA_H
 
-#include <QVector>
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Spectrum frames are recycled, not rebuilt: DSPThread takes a frame from a
+// SpectrumFramePool, writes the magnitudes in place and hands a reference
+// on; when the last reference goes the frame returns to the pool's free
+// list. Once the pool and the frames' storage have grown to fit the
+// current FFT size, producing a spectrum allocates nothing.
+//
+// Kept free of Qt like dspkernels.h, so bench/ can count its allocations.
+
+// Bin centre frequencies for one (sample rate, FFT size). Immutable and
+// shared by every frame with that configuration. Bins 1..N/2, matching
+// the magnitudes (DC is skipped).
+class FrequencyAxis {
+public:
+    FrequencyAxis(uint32_t sampleRate, uint32_t fftSize);
+
+    uint32_t sampleRate() const { return m_sampleRate; }
+    uint32_t fftSize() const { return m_fftSize; }
+    double binWidth() const { return (double)m_sampleRate / m_fftSize; }
+    int size() const { return (int)m_frequencies.size(); }
+    const double* data() const { return m_frequencies.data(); }
+
+    bool matches(uint32_t sampleRate, uint32_t fftSize) const {
+        return sampleRate == m_sampleRate && fftSize == m_fftSize;
+    }
+
+private:
+    uint32_t m_sampleRate;
+    uint32_t m_fftSize;
+    std::vector<double> m_frequencies;
+};
+
+typedef std::shared_ptr<const FrequencyAxis> FrequencyAxisPtr;
+
+class SpectrumFramePool;
+
+// CLOCK_MONOTONIC ns along a spectrum's way through DSPThread, for
+// latency tracing (LatencyStats). All 0 for spectra not made from samples.
+struct SpectrumTimes {
+    uint64_t captureNs;     // newest sample captured (PRU slot timestamp, back-dated)
+    uint64_t startNs;       // DSPThread started the group's last frame
+    uint64_t convertedNs;   // ... which is windowed into the FFT input
+    uint64_t publishedNs;   // FFT, power and dB done; handed to the bus
+
+    SpectrumTimes() : captureNs(0), startNs(0), convertedNs(0), publishedNs(0) {}
+};
 
-// Simple spectrum data structure
 struct SpectrumData {
-    QVector<double> frequencies;  // Hz (0 to 24000)
-    QVector<double> magnitudes;   // dB (-80 to 0)
-    uint32_t sampleRate;          // 48000
-    uint32_t fftSize;             // 1024
-    uint32_t numBins;             // 512
+    FrequencyAxisPtr axis;
+    double *magnitudes;         // dB (-80 to 0), numBins entries, 64-byte aligned
+    int numBins;                // axis->size()
+    double enbw;                // window noise bandwidth in bins; noise density
+                                // dB/Hz = dB - 10*log10(enbw * binWidth)
+    uint64_t sequence;          // published spectra since start, gaps = dropped
+    SpectrumTimes times;
+
+    uint32_t sampleRate() const { return axis->sampleRate(); }
+    uint32_t fftSize() const { return axis->fftSize(); }
+
+private:
+    friend class SpectrumFramePool;
+    friend class SpectrumFrameRef;
+
+    SpectrumData();
+    ~SpectrumData();
+
+    int m_capacity;
+    std::atomic<int> m_refs;
+    SpectrumFramePool *m_pool;
+};
+
+// Counted reference to a pooled frame, like a shared_ptr without the
+// control block allocation. Copying adds a reference; the frame goes back
+// to its pool when the last one is dropped.
+class SpectrumFrameRef {
+public:
+    SpectrumFrameRef() : m_frame(nullptr) {}
+    SpectrumFrameRef(const SpectrumFrameRef &other);
+    SpectrumFrameRef& operator=(const SpectrumFrameRef &other);
+    ~SpectrumFrameRef() { reset(); }
+
+    void reset();
+
+    SpectrumData* operator->() const { return m_frame; }
+    SpectrumData& operator*() const { return *m_frame; }
+    SpectrumData* get() const { return m_frame; }
+    explicit operator bool() const { return m_frame != nullptr; }
+
+private:
+    friend class SpectrumFramePool;
+    explicit SpectrumFrameRef(SpectrumData *frame) : m_frame(frame) {}
+
+    SpectrumData *m_frame;
 };
 
-Q_DECLARE_METATYPE(SpectrumData)
+class SpectrumFramePool {
+public:
+    // Preallocates `frames` frames; more are added if they all end up in
+    // use at once (counted in grown())
+    explicit SpectrumFramePool(int frames);
+    ~SpectrumFramePool();   // all references must be gone
+
+    // A frame with room for `bins` magnitudes. Everything but the storage
+    // is left to the caller to fill in. Empty if the storage can't be
+    // allocated; the caller skips that spectrum.
+    SpectrumFrameRef acquire(int bins);
+
+    // Size every free frame's storage for `bins` now (on an FFT size
+    // change) instead of on each frame's first acquire()
+    void reserve(int bins);
+
+    // Shared axis for this configuration; reused while it matches
+    FrequencyAxisPtr axis(uint32_t sampleRate, uint32_t fftSize);
+
+    int size() const;
+    int available() const;
+    uint64_t grown() const { return m_grown; }
+    uint64_t storageAllocations() const { return m_storageAllocations; }
+
+private:
+    friend class SpectrumFrameRef;
+    void recycle(SpectrumData *frame);
+    SpectrumData* create();
+    bool ensureStorage(SpectrumData *frame, int bins);
+
+    mutable std::mutex m_mutex;
+    std::vector<SpectrumData*> m_all;
+    std::vector<SpectrumData*> m_free;   // capacity kept >= m_all.size()
+    FrequencyAxisPtr m_axis;             // producer thread only
+    std::atomic<uint64_t> m_grown;
+    std::atomic<uint64_t> m_storageAllocations;
+};
 
 #endif
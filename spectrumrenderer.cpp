@@ -0,0 +1,202 @@
+#include "spectrumrenderer.h"
+#include "latencystats.h"
+#include "profiler.h"
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <cmath>
+
+SpectrumRenderer::SpectrumRenderer(const SpectrumSubscriptionPtr &spectra, QObject *parent)
+        : QThread(parent)
+        , m_spectra(spectra)
+        , m_running(false)
+        , m_backgroundChanged(false)
+        , m_showPersistence(false)
+        , m_framesReceived(0)
+        , m_framesRendered(0)
+        , m_renderNs(0)
+{
+}
+
+SpectrumRenderer::~SpectrumRenderer() {
+    stop();
+}
+
+void SpectrumRenderer::stop() {
+    m_running = false;
+    wait();
+}
+
+void SpectrumRenderer::setBackground(const QImage &background, const RenderGeometry &geometry) {
+    QMutexLocker locker(&m_backgroundMutex);
+    m_pendingBackground = background;
+    m_pendingGeometry = geometry;
+    m_backgroundChanged = true;
+}
+
+void SpectrumRenderer::rebuildLut(const FrequencyAxisPtr &axis) {
+    m_lutAxis = axis;
+
+    const QRect &rect = m_geometry.plotRect;
+    const int bins = axis->size();
+    const double *frequencies = axis->data();
+    m_binX.resize(bins);
+    if (m_geometry.keyLogarithmic) {
+        const double scale = rect.width() / log(m_geometry.keyUpper / m_geometry.keyLower);
+        for (int i = 0; i < bins; i++) {
+            m_binX[i] = log(frequencies[i] / m_geometry.keyLower) * scale + rect.left();
+        }
+    } else {
+        const double scale = rect.width() / (m_geometry.keyUpper - m_geometry.keyLower);
+        for (int i = 0; i < bins; i++) {
+            m_binX[i] = (frequencies[i] - m_geometry.keyLower) * scale + rect.left();
+        }
+    }
+
+    // Visible bins, plus one on each side so the line runs to the edges
+    int first = 0, last = bins - 1;
+    while (first < bins && m_binX[first] < rect.left()) {
+        first++;
+    }
+    while (last >= first && m_binX[last] > rect.right()) {
+        last--;
+    }
+    first = qMax(0, first - 1);
+    last = qMin(bins - 1, last + 1);
+
+    m_decimator.build(m_binX.constData(), first, last);
+    m_points.reserve(m_decimator.maxPoints());
+}
+
+void SpectrumRenderer::render(const SpectrumData &frame, uint64_t pickupNs) {
+    RenderedImage &rendered = m_images.writeBuffer();
+    rendered.times = frame.times;
+    rendered.pickupNs = pickupNs;
+    QImage &image = rendered.image;
+    if (image.size() != m_background.size()) {
+        // Only on resize
+        image = QImage(m_background.size(), QImage::Format_RGB32);
+    }
+
+    if (m_lutAxis != frame.axis) {
+        rebuildLut(frame.axis);
+    }
+
+    // Decimate in dB, then map the surviving points: y = y0 + dB * dy
+    const QRect &rect = m_geometry.plotRect;
+    const double dy = -rect.height() / (m_geometry.valueUpper - m_geometry.valueLower);
+    const double y0 = rect.bottom() - m_geometry.valueLower * dy;
+    m_points.resize(m_decimator.maxPoints());
+    QPointF *points = m_points.data();
+    const int count = m_decimator.decimate(frame.magnitudes, points);
+    for (int i = 0; i < count; i++) {
+        points[i].setY(y0 + points[i].y() * dy);
+    }
+
+    QPainter painter(&image);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(0, 0, m_background);
+    m_waterfall.draw(&painter, m_geometry.waterfallRect);
+    if (m_showPersistence) {
+        m_persistence.draw(&painter, rect);
+    }
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.setClipRect(rect);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(m_pen);
+    painter.drawPolyline(points, count);
+    painter.end();
+
+    m_images.publish();
+}
+
+void SpectrumRenderer::run() {
+    m_running = true;
+    Profiler::registerThread("render");
+    QElapsedTimer clock;
+    clock.start();
+    SpectrumFrameRef pending;   // newest frame not drawn yet
+    uint64_t due = 0;           // when the scheduler lets it be drawn
+
+    while (m_running) {
+        bool backgroundChanged = false;
+        if (m_backgroundChanged) {
+            QMutexLocker locker(&m_backgroundMutex);
+            m_background = m_pendingBackground;
+            m_geometry = m_pendingGeometry;
+            m_backgroundChanged = false;
+            m_lutAxis.reset();
+            m_waterfall.setDataRange(QCPRange(m_geometry.valueLower, m_geometry.valueUpper));
+            m_waterfall.setGeometry(m_geometry.waterfallRect.width(), m_geometry.waterfallRect.height(),
+                                    m_geometry.keyLower, m_geometry.keyUpper, m_geometry.keyLogarithmic);
+            if (m_showPersistence) {
+                m_persistence.setGeometry(m_geometry.plotRect.width(), m_geometry.plotRect.height(),
+                                          m_geometry.keyLower, m_geometry.keyUpper, m_geometry.keyLogarithmic,
+                                          m_geometry.valueLower, m_geometry.valueUpper);
+            }
+            backgroundChanged = true;
+        }
+
+        // Wait for a newer frame, but only until the pending one is due;
+        // never more than 50 ms, so a new background is picked up even
+        // when no spectra arrive
+        int timeoutMs = 50;
+        if (pending) {
+            uint64_t now = clock.nsecsElapsed();
+            timeoutMs = due > now ? (int)qMin<uint64_t>(50, (due - now + 999999) / 1000000) : 0;
+        }
+        SpectrumFrameRef frame = m_spectra->wait(timeoutMs);
+        if (!frame && m_spectra->closed()) {
+            break;
+        }
+
+        // Every queued spectrum scrolls the waterfall (one colorized row
+        // each) and lands in the persistence counts; only the newest is a
+        // candidate for the trace
+        while (frame) {
+            m_framesReceived++;
+            m_waterfall.addSpectrum(*frame);
+            if (m_showPersistence) {
+                m_persistence.addSpectrum(*frame);
+            }
+            SpectrumFrameRef next = m_spectra->take();
+            if (!next) {
+                break;
+            }
+            frame = next;
+        }
+        if (frame) {
+            due = m_scheduler.drawTime(*frame);
+            pending = due == RefreshScheduler::NEVER ? SpectrumFrameRef() : frame;
+        }
+        if (m_background.isNull()) {
+            continue;
+        }
+
+        uint64_t now = clock.nsecsElapsed();
+        bool drawPending = pending && now >= due;
+        if (!drawPending && !(backgroundChanged && m_lastFrame)) {
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        if (drawPending) {
+            render(*pending, LatencyStats::nowNs());
+            m_scheduler.drawn(*pending, now);
+            m_lastFrame = pending;
+            pending.reset();
+        } else {
+            // Same spectrum on the new background
+            render(*m_lastFrame, 0);
+        }
+        uint64_t elapsed = timer.nsecsElapsed();
+        Profiler::record(Profiler::Render, elapsed);
+        m_renderNs += elapsed;
+        m_framesRendered++;
+
+        emit frameRendered();
+    }
+
+    m_lastFrame.reset();
+}
@@ -0,0 +1,133 @@
+#ifndef SPECTRUMRENDERER_H
+#define SPECTRUMRENDERER_H
+
+#include <QThread>
+#include <QImage>
+#include <QMutex>
+#include <QPen>
+#include <QVector>
+#include <QPointF>
+#include <atomic>
+#include "spectrumbus.h"
+#include "columndecimator.h"
+#include "triplebuffer.h"
+#include "refreshscheduler.h"
+#include "waterfall.h"
+#include "persistence.h"
+
+// Where the plot area sits in the background image and what it shows;
+// the same mapping QCPAxis::coordToPixel does for a non-reversed axis
+struct RenderGeometry {
+    QRect plotRect;
+    QRect waterfallRect;             // empty: no waterfall
+    double keyLower, keyUpper;       // Hz
+    bool keyLogarithmic;
+    double valueLower, valueUpper;   // dB
+
+    RenderGeometry() : keyLower(1.0), keyUpper(2.0), keyLogarithmic(false),
+                       valueLower(0.0), valueUpper(1.0) {}
+};
+
+// Rasterizes spectra off the GUI thread. Each frame off the bus is drawn
+// into a QImage as the cached background (axes, grid, labels - rendered
+// by QCustomPlot on the GUI thread when the size or ranges change) plus
+// the decimated trace, optionally over the persistence counts, with the
+// waterfall ring under it when there is room for one. Finished images go through a triple buffer, so the
+// GUI thread only ever blits the newest one in paintEvent and neither
+// side waits on the other or copies an image. A RefreshScheduler decides
+// which frames are worth rendering at all.
+class SpectrumRenderer : public QThread {
+    Q_OBJECT
+
+public:
+    // `spectra` should be a Queue subscription: every frame in it becomes
+    // a waterfall row (and persistence hits), the newest one is drawn as
+    // the trace
+    explicit SpectrumRenderer(const SpectrumSubscriptionPtr &spectra, QObject *parent = nullptr);
+    ~SpectrumRenderer();
+
+    void stop();
+
+    // Call before start()
+    void setPen(const QPen &pen) { m_pen = pen; }
+    void setRefresh(double maxFps, double idleFps, double idleThresholdDb) {
+        m_scheduler.setMaxFps(maxFps);
+        m_scheduler.setIdleFps(idleFps);
+        m_scheduler.setIdleThreshold(idleThresholdDb);
+    }
+    // 0: no persistence under the trace
+    void setPersistence(int halfLife) {
+        m_showPersistence = halfLife > 0;
+        if (m_showPersistence) {
+            m_persistence.setHalfLife(halfLife);
+        }
+    }
+
+    // GUI thread. The last frame is redrawn on the new background.
+    void setBackground(const QImage &background, const RenderGeometry &geometry);
+
+    // GUI thread: moves to the newest finished image if there is one;
+    // currentImage() then stays valid until the next call
+    bool takeImage() { return m_images.acquire() != nullptr; }
+    const QImage& currentImage() const { return m_images.readBuffer().image; }
+    // The spectrum in currentImage() and when rendering it began; 0 for a
+    // redraw on a new background, which isn't a new spectrum
+    const SpectrumTimes& currentTimes() const { return m_images.readBuffer().times; }
+    uint64_t currentPickupNs() const { return m_images.readBuffer().pickupNs; }
+
+    // Since the last call: spectra received, renders and time spent
+    // rendering (renders can exceed spectra: a new background redraws)
+    void takeStats(uint64_t *received, uint64_t *rendered, uint64_t *ns) {
+        *received = m_framesReceived.exchange(0);
+        *rendered = m_framesRendered.exchange(0);
+        *ns = m_renderNs.exchange(0);
+    }
+
+signals:
+    // A new image is ready for takeImage(); queued to the GUI thread
+    void frameRendered();
+
+protected:
+    void run() override;
+
+private:
+    void render(const SpectrumData &frame, uint64_t pickupNs);
+    void rebuildLut(const FrequencyAxisPtr &axis);
+
+    SpectrumSubscriptionPtr m_spectra;
+    std::atomic<bool> m_running;
+    QPen m_pen;
+
+    // Background handed over by the GUI thread
+    QMutex m_backgroundMutex;
+    QImage m_pendingBackground;
+    RenderGeometry m_pendingGeometry;
+    std::atomic<bool> m_backgroundChanged;
+
+    // Render thread only
+    QImage m_background;
+    RenderGeometry m_geometry;
+    SpectrumFrameRef m_lastFrame;
+    FrequencyAxisPtr m_lutAxis;       // m_binX is for this axis and m_geometry
+    QVector<double> m_binX;
+    ColumnDecimator m_decimator;
+    QVector<QPointF> m_points;
+    RefreshScheduler m_scheduler;
+    Waterfall m_waterfall;
+    bool m_showPersistence;
+    Persistence m_persistence;
+
+    struct RenderedImage {
+        QImage image;
+        SpectrumTimes times;
+        uint64_t pickupNs;
+        RenderedImage() : pickupNs(0) {}
+    };
+    TripleBuffer<RenderedImage> m_images;
+
+    std::atomic<uint64_t> m_framesReceived;
+    std::atomic<uint64_t> m_framesRendered;
+    std::atomic<uint64_t> m_renderNs;
+};
+
+#endif
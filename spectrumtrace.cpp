@@ -0,0 +1,135 @@
+#include "spectrumtrace.h"
+
+SpectrumTrace::SpectrumTrace(QCPAxis *keyAxis, QCPAxis *valueAxis)
+        : QCPAbstractPlottable(keyAxis, valueAxis)
+        , m_lutScale(QCPAxis::stLinear)
+        , m_lutReversed(false)
+        , m_first(0)
+        , m_last(-1)
+        , m_lutRebuilds(0)
+{
+    setSelectable(QCP::stNone);
+}
+
+void SpectrumTrace::setSpectrum(const SpectrumFrameRef &frame) {
+    m_frame = frame;
+}
+
+void SpectrumTrace::clear() {
+    m_frame.reset();
+}
+
+double SpectrumTrace::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const {
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+    return -1;
+}
+
+QCPRange SpectrumTrace::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const {
+    Q_UNUSED(inSignDomain)
+    foundRange = m_frame && m_frame->numBins > 0;
+    if (!foundRange) {
+        return QCPRange();
+    }
+    const FrequencyAxis &axis = *m_frame->axis;
+    return QCPRange(axis.data()[0], axis.data()[axis.size() - 1]);
+}
+
+QCPRange SpectrumTrace::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
+                                      const QCPRange &inKeyRange) const {
+    Q_UNUSED(inSignDomain)
+    Q_UNUSED(inKeyRange)
+    foundRange = m_frame && m_frame->numBins > 0;
+    if (!foundRange) {
+        return QCPRange();
+    }
+    const double *db = m_frame->magnitudes;
+    QCPRange range(db[0], db[0]);
+    for (int i = 1; i < m_frame->numBins; i++) {
+        range.expand(db[i]);
+    }
+    return range;
+}
+
+bool SpectrumTrace::lutValid() const {
+    const QCPAxis *key = mKeyAxis.data();
+    return m_lutAxis == m_frame->axis
+            && m_lutRange == key->range()
+            && m_lutScale == key->scaleType()
+            && m_lutReversed == key->rangeReversed()
+            && m_lutRect == key->axisRect()->rect();
+}
+
+void SpectrumTrace::rebuildLut() {
+    QCPAxis *key = mKeyAxis.data();
+    m_lutAxis = m_frame->axis;
+    m_lutRange = key->range();
+    m_lutScale = key->scaleType();
+    m_lutReversed = key->rangeReversed();
+    m_lutRect = key->axisRect()->rect();
+
+    // coordToPixel itself, so the trace lines up with ticks and grid exactly
+    const int bins = m_lutAxis->size();
+    const double *frequencies = m_lutAxis->data();
+    m_binX.resize(bins);
+    for (int i = 0; i < bins; i++) {
+        m_binX[i] = key->coordToPixel(frequencies[i]);
+    }
+
+    // Visible bins, plus one on each side so the line runs to the edges
+    const double left = m_lutRect.left(), right = m_lutRect.right();
+    m_first = 0;
+    m_last = bins - 1;
+    while (m_first < bins && (m_binX[m_first] < left || m_binX[m_first] > right)) {
+        m_first++;
+    }
+    while (m_last >= m_first && (m_binX[m_last] < left || m_binX[m_last] > right)) {
+        m_last--;
+    }
+    m_first = qMax(0, m_first - 1);
+    m_last = qMin(bins - 1, m_last + 1);
+
+    m_decimator.build(m_binX.constData(), m_first, m_last);
+    m_points.reserve(m_decimator.maxPoints());
+    m_lutRebuilds++;
+}
+
+void SpectrumTrace::draw(QCPPainter *painter) {
+    if (!m_frame || m_frame->numBins == 0 || !mKeyAxis || !mValueAxis) {
+        return;
+    }
+    if (!lutValid()) {
+        rebuildLut();
+    }
+    if (m_last < m_first) {
+        return;
+    }
+
+    // Value axis is linear in dB: y = y0 + dB * dy
+    const QCPAxis *value = mValueAxis.data();
+    const double y0 = value->coordToPixel(0.0);
+    const double dy = value->coordToPixel(1.0) - y0;
+    const bool linear = value->scaleType() == QCPAxis::stLinear;
+
+    // Decimate in dB, then map only the surviving points
+    m_points.resize(m_decimator.maxPoints());
+    QPointF *points = m_points.data();
+    const int count = m_decimator.decimate(m_frame->magnitudes, points);
+    m_points.resize(count);
+    for (int i = 0; i < count; i++) {
+        const double db = points[i].y();
+        points[i].setY(linear ? y0 + db * dy : value->coordToPixel(db));
+    }
+
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPolyline(points, count);
+}
+
+void SpectrumTrace::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const {
+    applyDefaultAntialiasingHint(painter);
+    painter->setPen(mPen);
+    painter->drawLine(QLineF(rect.left(), rect.center().y(), rect.right(), rect.center().y()));
+}
@@ -0,0 +1,69 @@
+#ifndef SPECTRUMTRACE_H
+#define SPECTRUMTRACE_H
+
+#include "qcustomplot.h"
+#include "spectrumdata.h"
+#include "columndecimator.h"
+
+// QCustomPlot plottable for one spectrum with a fixed bin layout.
+//
+// QCPGraph::setData() rebuilds its sorted data container on every update
+// and replot maps every point through QCPAxis::coordToPixel (a log per
+// point on the log frequency axis). Here the bins' x pixels are computed
+// once into a lookup table and only recomputed when the key axis range,
+// scale or the axis rect changes. The same rebuild groups the bins into
+// pixel columns (ColumnDecimator), so each replot draws at most four
+// points per column straight from the frame's magnitudes, however many
+// bins the FFT size gives.
+//
+// Horizontal key axis only (frequency along x), which is all the UI uses.
+class SpectrumTrace : public QCPAbstractPlottable {
+    Q_OBJECT
+
+public:
+    SpectrumTrace(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    // Holds a reference to the frame until the next one; no copy
+    void setSpectrum(const SpectrumFrameRef &frame);
+    void clear();
+
+    const SpectrumFrameRef& spectrum() const { return m_frame; }
+
+    // Times the pixel table was rebuilt (resize, range or FFT size change)
+    int lutRebuilds() const { return m_lutRebuilds; }
+
+    // Points in the last drawn polyline (<= 4 per pixel column)
+    int drawnPoints() const { return m_points.size(); }
+
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth,
+                           const QCPRange &inKeyRange = QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private:
+    bool lutValid() const;
+    void rebuildLut();
+
+    SpectrumFrameRef m_frame;
+
+    // x pixel per bin for m_lutAxis under the cached key range and rect;
+    // m_first..m_last are the bins worth drawing (one beyond each edge)
+    FrequencyAxisPtr m_lutAxis;
+    QCPRange m_lutRange;
+    QCPAxis::ScaleType m_lutScale;
+    bool m_lutReversed;
+    QRect m_lutRect;
+    QVector<double> m_binX;
+    int m_first;
+    int m_last;
+    int m_lutRebuilds;
+    ColumnDecimator m_decimator;
+
+    QVector<QPointF> m_points;   // reused polyline, capacity = maxPoints()
+};
+
+#endif
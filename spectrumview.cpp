@@ -0,0 +1,50 @@
+#include "spectrumview.h"
+#include "profiler.h"
+#include <QPainter>
+#include <QElapsedTimer>
+#include <QResizeEvent>
+
+SpectrumView::SpectrumView(SpectrumRenderer *renderer, QWidget *parent)
+        : QWidget(parent)
+        , m_renderer(renderer)
+        , m_backgroundColor(Qt::black)
+        , m_latency(nullptr)
+        , m_blits(0)
+        , m_blitNs(0)
+{
+    // Every pixel is painted each time; skip Qt's background erase
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    connect(m_renderer, &SpectrumRenderer::frameRendered,
+            this, static_cast<void (QWidget::*)()>(&QWidget::update));
+}
+
+void SpectrumView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event)
+    QElapsedTimer timer;
+    timer.start();
+
+    bool fresh = m_renderer->takeImage();
+    const QImage &image = m_renderer->currentImage();
+
+    QPainter painter(this);
+    if (image.size() != size()) {
+        painter.fillRect(rect(), m_backgroundColor);
+    }
+    if (!image.isNull()) {
+        painter.drawImage(0, 0, image);
+    }
+    if (fresh && m_latency && m_renderer->currentPickupNs()) {
+        m_latency->record(m_renderer->currentTimes(), m_renderer->currentPickupNs(),
+                          LatencyStats::nowNs());
+    }
+
+    uint64_t elapsed = timer.nsecsElapsed();
+    Profiler::record(Profiler::Replot, elapsed);
+    m_blitNs += elapsed;
+    m_blits++;
+}
+
+void SpectrumView::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    emit resized(event->size());
+}
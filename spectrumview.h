@@ -0,0 +1,47 @@
+#ifndef SPECTRUMVIEW_H
+#define SPECTRUMVIEW_H
+
+#include <QWidget>
+#include <QColor>
+#include <cstdint>
+#include "spectrumrenderer.h"
+#include "latencystats.h"
+
+// Shows SpectrumRenderer's newest image. paintEvent is a single blit; all
+// drawing happens on the render thread.
+class SpectrumView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SpectrumView(SpectrumRenderer *renderer, QWidget *parent = nullptr);
+
+    // Fill for the area the current image doesn't cover (before the first
+    // frame and right after a resize)
+    void setBackgroundColor(const QColor &color) { m_backgroundColor = color; }
+
+    // Each new spectrum's latency goes here once it has been blitted;
+    // nullptr to stop
+    void setLatencyStats(LatencyStats *stats) { m_latency = stats; }
+
+    // Since the last resetStats()
+    uint64_t blits() const { return m_blits; }
+    uint64_t blitNs() const { return m_blitNs; }
+    void resetStats() { m_blits = 0; m_blitNs = 0; }
+
+signals:
+    // The renderer needs a background of this size
+    void resized(const QSize &size);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    SpectrumRenderer *m_renderer;
+    QColor m_backgroundColor;
+    LatencyStats *m_latency;
+    uint64_t m_blits;
+    uint64_t m_blitNs;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef SPECTRUMWRITER_H
+#define SPECTRUMWRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "spectrumdata.h"
+
+// Writes spectra as a compact framed binary stream, for headless runs
+// (stdout, a file or a named pipe). Every spectrum is one record: a fixed
+// header that describes it fully, then its bins, so a reader can start
+// anywhere by scanning for the magic and streams can simply be
+// concatenated. All fields little-endian (native on the BeagleBone and on
+// x86).
+//
+//   offset  size  field
+//        0     4  magic "SPEC"
+//        4     1  version (1)
+//        5     1  format: 1 = float32 dB, 2 = int16 centi-dB (dB * 100)
+//        6     2  header size in bytes (40); bins start here
+//        8     4  sample rate, Hz
+//       12     4  FFT size N
+//       16     4  bins, N / 2: bin i is (i + 1) * rate / N Hz (DC skipped)
+//       20     4  float32 window ENBW, bins
+//       24     8  sequence (gaps: spectra the writer fell behind on)
+//       32     8  capture time of the newest sample, CLOCK_MONOTONIC ns
+//                 (0 if not traced)
+//
+// Each record goes out with one writev() (more only when a pipe takes
+// part of it), and nothing is allocated per spectrum once the bin buffer
+// has grown to the FFT size.
+class SpectrumWriter {
+public:
+    enum Format {
+        Float32 = 1,
+        Int16 = 2
+    };
+
+    static const int HEADER_BYTES = 40;
+
+    explicit SpectrumWriter(Format format);
+    ~SpectrumWriter();
+
+    // "-" is stdout. Opening a named pipe waits for its reader.
+    bool open(const std::string &path);
+    void close();
+
+    // False once a write has failed (reader gone, disk full); see error()
+    bool write(const SpectrumData &frame);
+
+    uint64_t spectraWritten() const { return m_spectra; }
+    uint64_t bytesWritten() const { return m_bytes; }
+    const std::string& error() const { return m_error; }
+
+private:
+    Format m_format;
+    int m_fd;
+    bool m_ownsFd;
+    uint8_t m_header[HEADER_BYTES];
+    std::vector<uint8_t> m_bins;   // converted to m_format
+    uint64_t m_spectra;
+    uint64_t m_bytes;
+    std::string m_error;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Wait-free latest-value channel between one writer and one reader thread.
+//
+// Three slots: the writer fills its back slot in place and publish() swaps
+// it with the middle one; the reader's acquire() swaps the middle one with
+// its front slot if something new was published. Each side only touches
+// its own slot between swaps, so nothing is copied or locked, and a slow
+// reader never holds up the writer - it just sees the newest value when it
+// gets round to it. Values it never saw are counted in overwritten().
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+            : m_state(1)
+            , m_back(0)
+            , m_front(2)
+            , m_published(0)
+            , m_overwritten(0)
+    {}
+
+    // Writer: the slot to fill; stays the writer's until publish()
+    T& writeBuffer() { return m_slots[m_back]; }
+
+    void publish() {
+        uint8_t previous = m_state.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        if (previous & FRESH) {
+            m_overwritten.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_back = previous & INDEX_MASK;
+        m_published.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Reader: the newest published value if there is one the reader hasn't
+    // had yet, otherwise nullptr. Valid until the next acquire().
+    const T* acquire() {
+        if (!(m_state.load(std::memory_order_relaxed) & FRESH)) {
+            return nullptr;
+        }
+        uint8_t previous = m_state.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return &m_slots[m_front];
+    }
+
+    // Reader: whatever acquire() last returned
+    const T& readBuffer() const { return m_slots[m_front]; }
+
+    uint64_t published() const { return m_published.load(std::memory_order_relaxed); }
+    uint64_t overwritten() const { return m_overwritten.load(std::memory_order_relaxed); }
+
+private:
+    enum {
+        INDEX_MASK = 0x3,
+        FRESH = 0x4     // middle slot holds a value the reader hasn't taken
+    };
+
+    T m_slots[3];
+    std::atomic<uint8_t> m_state;   // middle slot index | FRESH
+    int m_back;                     // writer only
+    int m_front;                    // reader only
+    std::atomic<uint64_t> m_published;
+    std::atomic<uint64_t> m_overwritten;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "waterfall.h"
+#include <cmath>
+
+Waterfall::Waterfall()
+        : m_newest(0)
+        , m_gradient(QCPColorGradient::gpThermal)
+        , m_range(-80.0, 0.0)
+        , m_keyLower(1.0)
+        , m_keyUpper(2.0)
+        , m_keyLogarithmic(false)
+{
+}
+
+void Waterfall::setGeometry(int width, int height, double keyLower, double keyUpper, bool keyLogarithmic) {
+    if (width == m_image.width() && height == m_image.height() && keyLower == m_keyLower
+            && keyUpper == m_keyUpper && keyLogarithmic == m_keyLogarithmic) {
+        return;
+    }
+    m_keyLower = keyLower;
+    m_keyUpper = keyUpper;
+    m_keyLogarithmic = keyLogarithmic;
+    m_columnsAxis.reset();
+
+    if (width <= 0 || height <= 0) {
+        m_image = QImage();
+        return;
+    }
+    m_image = QImage(width, height, QImage::Format_RGB32);
+    m_row.resize(width);
+    clear();
+}
+
+void Waterfall::clear() {
+    m_image.fill(m_gradient.color(m_range.lower, m_range));
+    m_newest = 0;
+}
+
+double Waterfall::keyAt(double column) const {
+    double t = column / m_image.width();
+    if (m_keyLogarithmic) {
+        return m_keyLower * pow(m_keyUpper / m_keyLower, t);
+    }
+    return m_keyLower + (m_keyUpper - m_keyLower) * t;
+}
+
+void Waterfall::rebuildColumns(const FrequencyAxisPtr &axis) {
+    m_columnsAxis = axis;
+    const int width = m_image.width();
+    const int bins = axis->size();
+    const double binWidth = axis->binWidth();
+    m_columnStart.resize(width);
+    m_columnEnd.resize(width);
+
+    // Bin i is at (i + 1) * binWidth (DC is skipped)
+    for (int c = 0; c < width; c++) {
+        int start = (int)ceil(keyAt(c) / binWidth - 1.0);
+        int end = (int)ceil(keyAt(c + 1) / binWidth - 1.0);
+        start = qBound(0, start, bins);
+        end = qBound(0, end, bins);
+        if (end <= start) {
+            start = qBound(0, (int)floor(keyAt(c + 0.5) / binWidth - 0.5), bins - 1);
+            end = start + 1;
+        }
+        m_columnStart[c] = start;
+        m_columnEnd[c] = end;
+    }
+}
+
+void Waterfall::addSpectrum(const SpectrumData &frame) {
+    if (m_image.isNull() || frame.numBins == 0) {
+        return;
+    }
+    if (m_columnsAxis != frame.axis) {
+        rebuildColumns(frame.axis);
+    }
+
+    // Peak per column
+    const double *db = frame.magnitudes;
+    const int width = m_image.width();
+    for (int c = 0; c < width; c++) {
+        double peak = db[m_columnStart[c]];
+        for (int i = m_columnStart[c] + 1; i < m_columnEnd[c]; i++) {
+            peak = qMax(peak, db[i]);
+        }
+        m_row[c] = peak;
+    }
+
+    m_newest = (m_newest + m_image.height() - 1) % m_image.height();
+    QRgb *line = reinterpret_cast<QRgb*>(m_image.scanLine(m_newest));
+    m_gradient.colorize(m_row.data(), m_range, line, width);
+}
+
+void Waterfall::draw(QPainter *painter, const QRect &target) const {
+    if (m_image.isNull()) {
+        return;
+    }
+    // Newest..bottom of the ring, then the wrapped part below it
+    const int width = m_image.width(), height = m_image.height();
+    const int upper = height - m_newest;
+    painter->drawImage(target.topLeft(), m_image, QRect(0, m_newest, width, upper));
+    if (m_newest > 0) {
+        painter->drawImage(target.topLeft() + QPoint(0, upper), m_image, QRect(0, 0, width, m_newest));
+    }
+}
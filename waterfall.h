@@ -0,0 +1,61 @@
+#ifndef WATERFALL_H
+#define WATERFALL_H
+
+#include <QImage>
+#include <QPainter>
+#include <vector>
+#include "qcustomplot.h"
+#include "spectrumdata.h"
+
+// Spectrogram history as a ring of pre-colorized scanlines.
+//
+// QCPColorMap regenerates its whole image whenever its data changes, which
+// is width x height work per spectrum. Here every spectrum becomes one new
+// scanline: the bins are reduced to one value per pixel column (the peak,
+// so narrow lines survive) and QCPColorGradient::colorize writes just that
+// row into the ring. Older rows are never touched again; draw() blits the
+// ring in two pieces around the wrap point, newest row at the top. Adding
+// a spectrum is O(width + bins).
+//
+// Not thread safe; used by one thread (render thread or GUI thread).
+class Waterfall {
+public:
+    Waterfall();
+
+    void setGradient(const QCPColorGradient &gradient) { m_gradient = gradient; }
+    void setDataRange(const QCPRange &db) { m_range = db; }
+
+    // One pixel column per ring column and one row per spectrum, over the
+    // same key range as the trace above it. Clears the history when
+    // anything changes.
+    void setGeometry(int width, int height, double keyLower, double keyUpper, bool keyLogarithmic);
+    int width() const { return m_image.width(); }
+    int height() const { return m_image.height(); }
+
+    void addSpectrum(const SpectrumData &frame);
+    void clear();
+
+    // Draws the ring unscaled with its top left corner at target's
+    void draw(QPainter *painter, const QRect &target) const;
+
+private:
+    void rebuildColumns(const FrequencyAxisPtr &axis);
+    double keyAt(double column) const;
+
+    QImage m_image;     // Format_RGB32, one row per spectrum
+    int m_newest;       // row of the newest spectrum
+    QCPColorGradient m_gradient;
+    QCPRange m_range;
+
+    double m_keyLower, m_keyUpper;
+    bool m_keyLogarithmic;
+
+    // Bins [m_columnStart[c], m_columnEnd[c]) fall in pixel column c; a
+    // column between two bins (low end of the log axis) takes the nearest
+    FrequencyAxisPtr m_columnsAxis;
+    std::vector<int> m_columnStart;
+    std::vector<int> m_columnEnd;
+    std::vector<double> m_row;
+};
+
+#endif
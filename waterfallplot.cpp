@@ -0,0 +1,56 @@
+#include "waterfallplot.h"
+
+WaterfallPlot::WaterfallPlot(QCPAxis *keyAxis, QCPAxis *valueAxis)
+        : QCPAbstractPlottable(keyAxis, valueAxis)
+{
+    setSelectable(QCP::stNone);
+}
+
+void WaterfallPlot::updateGeometry() {
+    QCPAxis *key = mKeyAxis.data();
+    const QRect rect = key->axisRect()->rect();
+    m_waterfall.setGeometry(rect.width(), rect.height(), key->range().lower, key->range().upper,
+                            key->scaleType() == QCPAxis::stLogarithmic);
+}
+
+void WaterfallPlot::addSpectrum(const SpectrumData &frame) {
+    if (!mKeyAxis) {
+        return;
+    }
+    updateGeometry();
+    m_waterfall.addSpectrum(frame);
+}
+
+double WaterfallPlot::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const {
+    Q_UNUSED(pos)
+    Q_UNUSED(onlySelectable)
+    Q_UNUSED(details)
+    return -1;
+}
+
+QCPRange WaterfallPlot::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const {
+    Q_UNUSED(inSignDomain)
+    foundRange = false;
+    return QCPRange();
+}
+
+QCPRange WaterfallPlot::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
+                                      const QCPRange &inKeyRange) const {
+    Q_UNUSED(inSignDomain)
+    Q_UNUSED(inKeyRange)
+    foundRange = false;
+    return QCPRange();
+}
+
+void WaterfallPlot::draw(QCPPainter *painter) {
+    if (!mKeyAxis) {
+        return;
+    }
+    updateGeometry();
+    m_waterfall.draw(painter, mKeyAxis->axisRect()->rect());
+}
+
+void WaterfallPlot::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const {
+    Q_UNUSED(painter)
+    Q_UNUSED(rect)
+}
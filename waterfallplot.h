@@ -0,0 +1,37 @@
+#ifndef WATERFALLPLOT_H
+#define WATERFALLPLOT_H
+
+#include "qcustomplot.h"
+#include "waterfall.h"
+
+// QCustomPlot plottable around a Waterfall ring, for the GUI thread
+// renderers. Fills its key axis' axis rect; the ring follows that rect's
+// size and the key axis range (history is cleared when they change).
+class WaterfallPlot : public QCPAbstractPlottable {
+    Q_OBJECT
+
+public:
+    WaterfallPlot(QCPAxis *keyAxis, QCPAxis *valueAxis);
+
+    Waterfall& waterfall() { return m_waterfall; }
+
+    // One row per spectrum; shows at the next replot
+    void addSpectrum(const SpectrumData &frame);
+    void clear() { m_waterfall.clear(); }
+
+    double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details = nullptr) const override;
+    QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth) const override;
+    QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain = QCP::sdBoth,
+                           const QCPRange &inKeyRange = QCPRange()) const override;
+
+protected:
+    void draw(QCPPainter *painter) override;
+    void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const override;
+
+private:
+    void updateGeometry();
+
+    Waterfall m_waterfall;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "windowtable.h"
+#include <QStringList>
+#include <cmath>
+
+QMutex WindowTable::s_cacheMutex;
+QMap<WindowTable::Key, QSharedPointer<const WindowTable> > WindowTable::s_cache;
+
+// Zeroth order modified Bessel function of the first kind, power series
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    double q = x * x / 4.0;
+    for (int k = 1; k < 100; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Sum of cosines: a0 - a1 cos(x) + a2 cos(2x) - ...
+static double cosineSum(const double *a, int terms, double x) {
+    double w = 0.0;
+    for (int k = 0; k < terms; k++) {
+        w += (k & 1 ? -a[k] : a[k]) * cos(k * x);
+    }
+    return w;
+}
+
+WindowTable::WindowTable(Type type, int n, double parameter)
+        : m_type(type)
+        , m_parameter(type == Kaiser ? parameter : 0.0)
+        , m_coefficients(n)
+{
+    static const double HANN[] = { 0.5, 0.5 };
+    static const double HAMMING[] = { 0.54, 0.46 };
+    static const double BLACKMAN_HARRIS[] = { 0.35875, 0.48829, 0.14128, 0.01168 };
+    static const double FLAT_TOP[] = { 0.21557895, 0.41663158, 0.277263158,
+                                       0.083578947, 0.006947368 };
+
+    // Symmetric windows over n - 1, like the original Hann
+    const double denom = n > 1 ? n - 1 : 1;
+    double *w = m_coefficients.data();
+
+    for (int i = 0; i < n; i++) {
+        double x = 2.0 * M_PI * i / denom;
+        switch (type) {
+        case Hann:            w[i] = cosineSum(HANN, 2, x); break;
+        case Hamming:         w[i] = cosineSum(HAMMING, 2, x); break;
+        case BlackmanHarris4: w[i] = cosineSum(BLACKMAN_HARRIS, 4, x); break;
+        case FlatTop:         w[i] = cosineSum(FLAT_TOP, 5, x); break;
+        case Kaiser: {
+            double r = 2.0 * i / denom - 1.0;
+            w[i] = besselI0(m_parameter * sqrt(qMax(0.0, 1.0 - r * r))) / besselI0(m_parameter);
+            break;
+        }
+        }
+    }
+
+    double sum = 0.0, sumSquares = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += w[i];
+        sumSquares += w[i] * w[i];
+    }
+    m_coherentGain = n > 0 ? sum / n : 1.0;
+    m_enbw = sum != 0.0 ? n * sumSquares / (sum * sum) : 1.0;
+}
+
+QString WindowTable::name() const {
+    switch (m_type) {
+    case Hann:            return "hann";
+    case Hamming:         return "hamming";
+    case BlackmanHarris4: return "bh4";
+    case FlatTop:         return "flattop";
+    case Kaiser:          return QString("kaiser:%1").arg(m_parameter);
+    }
+    return QString();
+}
+
+QSharedPointer<const WindowTable> WindowTable::get(Type type, int n, double parameter) {
+    Key key;
+    key.type = type;
+    key.n = n;
+    key.parameter = type == Kaiser ? parameter : 0.0;
+
+    QMutexLocker locker(&s_cacheMutex);
+    QSharedPointer<const WindowTable> table = s_cache.value(key);
+    if (table.isNull()) {
+        table = QSharedPointer<const WindowTable>(new WindowTable(type, n, parameter));
+        s_cache.insert(key, table);
+    }
+    return table;
+}
+
+bool WindowTable::parse(const QString &spec, Type *type, double *parameter) {
+    QStringList parts = spec.trimmed().toLower().split(':');
+    QString kind = parts.value(0);
+    *parameter = 0.0;
+
+    if (kind == "hann") {
+        *type = Hann;
+    } else if (kind == "hamming") {
+        *type = Hamming;
+    } else if (kind == "bh4" || kind == "blackman-harris") {
+        *type = BlackmanHarris4;
+    } else if (kind == "flattop") {
+        *type = FlatTop;
+    } else if (kind == "kaiser") {
+        *type = Kaiser;
+        *parameter = 9.0;
+        if (parts.size() > 1) {
+            bool ok = false;
+            *parameter = parts[1].toDouble(&ok);
+            if (!ok || *parameter < 0.0) {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
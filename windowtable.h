@@ -0,0 +1,69 @@
+#ifndef WINDOWTABLE_H
+#define WINDOWTABLE_H
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+
+// FFT window functions, computed once per (type, size, parameter) and then
+// shared. Each table carries the two numbers the spectrum scaling needs:
+//
+//   coherentGain = sum(w) / N           tone amplitude: |X| / (N * gain)
+//   enbw         = N * sum(w^2) / sum(w)^2   noise bandwidth in bins;
+//                                       density = power / (enbw * fs / N)
+//
+// Tables hold the plain window; DSPThread multiplies in the ADC scale when
+// it copies one into its FFT buffers, so the frame kernel stays a single
+// multiply per sample.
+class WindowTable {
+public:
+    enum Type {
+        Hann,
+        Hamming,
+        BlackmanHarris4,   // 4-term, -92 dB sidelobes
+        FlatTop,           // 5-term, amplitude accurate to ~0.01 dB between bins
+        Kaiser             // parameter = beta
+    };
+
+    WindowTable(Type type, int n, double parameter);
+
+    Type type() const { return m_type; }
+    int size() const { return m_coefficients.size(); }
+    double parameter() const { return m_parameter; }
+    const double* coefficients() const { return m_coefficients.constData(); }
+    double coherentGain() const { return m_coherentGain; }
+    double enbw() const { return m_enbw; }
+    QString name() const;
+
+    // Shared table for (type, n, parameter); computed on first use.
+    // Thread safe.
+    static QSharedPointer<const WindowTable> get(Type type, int n, double parameter = 0.0);
+
+    // "hann", "hamming", "bh4", "flattop", "kaiser[:beta]" (default beta 9)
+    static bool parse(const QString &spec, Type *type, double *parameter);
+
+private:
+    struct Key {
+        int type;
+        int n;
+        double parameter;
+        bool operator<(const Key &o) const {
+            if (type != o.type) return type < o.type;
+            if (n != o.n) return n < o.n;
+            return parameter < o.parameter;
+        }
+    };
+
+    static QMutex s_cacheMutex;
+    static QMap<Key, QSharedPointer<const WindowTable> > s_cache;
+
+    Type m_type;
+    double m_parameter;
+    QVector<double> m_coefficients;
+    double m_coherentGain;
+    double m_enbw;
+};
+
+#endif